@@ -27,12 +27,27 @@
 #include "fhe_poly.h"
 #include "fhe_ring.h"
 
+///
+/// \brief Default number of key switching digits, one RNS limb per digit
+/// Key switching has no special modulus, so its noise grows with the
+/// largest digit. Single limb digits keep it to the size of one residue.
+///
+#define BGV_DNUM SIZE_MAX
+
+///
+/// \brief Flag set in the polynomial count of a seeded ciphertext header
+/// Keeps bgv_ct_deserialize and bgv_ct_deserialize_seeded from reading each
+/// other's byte streams.
+///
+#define BGV_CT_SEEDED 0x80000000u
+
 ///
 /// \brief Main BGV type used to instantiate the scheme.
 ///
 typedef struct bgv_t {
-  size_t t; ///< Plaintext modulus \f$t\f$
-  ring_t r; ///< Polynomial ring \f$R_q = Z_q[x]/<x^d + 1>\f$
+  size_t t;    ///< Plaintext modulus \f$t\f$
+  size_t dnum; ///< Number of key switching digits
+  ring_t r;    ///< Polynomial ring \f$R_q = Z_q[x]/<x^d + 1>\f$
 } bgv_t;
 
 ///
@@ -43,15 +58,85 @@ typedef struct bgv_keypair_t {
   poly_t b; ///< Polynomial b
 } bgv_keypair_t;
 
+///
+/// \brief Key switching key from a secret \f$s'\f$ to the secret \f$s\f$
+///
+/// The RNS limbs of \f$q\f$ are split into dnum digits of alpha consecutive
+/// limbs with products \f$Q_j\f$. Digit \f$j\f$ holds
+/// \f$(a_j, -a_j s + t e_j + (q / Q_j) s')\f$, so the noise of a key switch
+/// grows with \f$\max Q_j\f$ instead of \f$q\f$. Keys are generated at the
+/// top level and serve ciphertexts at every level. The uniform \f$a_j\f$
+/// are expanded from a seed, which serialized keys store in their place.
+///
+typedef struct bgv_ksk_t {
+  size_t dnum;      ///< Number of digits
+  size_t alpha;     ///< Number of RNS limbs per digit
+  bgv_keypair_t *k; ///< One key pair per digit
+  uint_t *tab;      ///< Digit constants of every level, set by bgv_ksk_init
+  /// Seed of the \f$a_j\f$, expanded with index j
+  unsigned char seed[POLY_SEED_BYTES];
+} bgv_ksk_t;
+
 ///
 /// \brief BGV key pair used to encrypt, decrypt, and relinearize a ciphertext.
 ///
 typedef struct bgv_key_t {
-  poly_t s;           ///< Secret key \f$s \in R_q\f$
-  bgv_keypair_t pub;  ///< Public key pair \f$(a, b) \in R_q\f$
-  bgv_keypair_t eval; ///< Evaluation key pair \f$(a, b) \in R_q\f$
+  poly_t s;          ///< Secret key \f$s \in R_q\f$
+  bgv_keypair_t pub; ///< Public key pair \f$(a, b) \in R_q\f$
+  bgv_ksk_t eval;    ///< Relinearization key from \f$s^2\f$ to \f$s\f$
+  /// Seed of the public a, expanded with index 0
+  unsigned char seed[POLY_SEED_BYTES];
 } bgv_key_t;
 
+///
+/// \brief Pre-encoded BGV plaintext
+/// Coefficients are reduced mod t, centered and kept in NTT form, so a
+/// plaintext used many times is encoded once.
+///
+typedef struct bgv_pt_t {
+  poly_t p; ///< Encoded plaintext in NTT form
+} bgv_pt_t;
+
+///
+/// \brief Galois keys for a set of automorphisms \f$x \mapsto x^g\f$
+///
+typedef struct bgv_galois_t {
+  size_t n;     ///< Number of keys
+  size_t *g;    ///< Galois elements, odd and below 2d
+  bgv_ksk_t *k; ///< Key switching keys from \f$s(x^g)\f$ to \f$s\f$
+} bgv_galois_t;
+
+///
+/// \brief Slot encoder for a plaintext modulus \f$t \equiv 1 \bmod 2d\f$
+/// \f$x^d + 1\f$ then splits into linear factors mod t and a plaintext
+/// holds d values mod t, one per root. Products of ciphertexts act slot
+/// wise. Slots are arranged in two rows of d / 2 following the powers of
+/// the rotation generator 3, so bgv_ct_rotate by k moves slot i + k of
+/// each row to slot i, and the conjugation \f$x \mapsto x^{2d - 1}\f$
+/// swaps the rows.
+///
+typedef struct bgv_batch_t {
+  uint_t t;             ///< Plaintext modulus
+  size_t lgd;           ///< log d where d is the number of slots
+  uint_t *roots;        ///< Powers of a primitive 2d-th root mod t
+  uint_t *roots_shoup;  ///< floor(roots * 2^64 / t)
+  uint_t *iroots;       ///< Inverse powers of the root
+  uint_t *iroots_shoup; ///< floor(iroots * 2^64 / t)
+  uint_t dinv;          ///< [d]_t^-1
+  uint_t dinv_shoup;    ///< floor(dinv * 2^64 / t)
+  size_t *slot;         ///< Transform index of each slot
+} bgv_batch_t;
+
+///
+/// \brief Pool of precomputed encryptions of zero under a public key
+/// The sampling, transforms and products of an encryption do not depend
+/// on the message. They are done ahead of time, by bgv_encpool_fill or a
+/// background thread, and an encryption then only adds the message.
+///
+typedef struct bgv_encpool_t {
+  void *state; ///< Cached encryptions and worker, see bgv_encpool.c
+} bgv_encpool_t;
+
 ///
 /// \brief BGV Ciphertext consists of \f$n\f$ polynomials over
 /// the ciphertext ring \f$R_q = Z_q[x]/<x^d + 1>\f$
@@ -59,6 +144,11 @@ typedef struct bgv_key_t {
 /// Note: The Ciphertext size \f$n\f$ increases by one after every
 /// multiplication.
 ///
+/// The level of a ciphertext is carried by its polynomials: at level l
+/// they are defined mod \f$q_l = m_0 \cdots m_l\f$. Fresh ciphertexts
+/// start at the top level \f$r.n - 1\f$ and bgv_ct_modswitch moves them
+/// one level down.
+///
 typedef struct bgv_ct_t {
   size_t n;  ///< Number of polynomials
   poly_t *c; ///< \f$n\f$ Ciphertext polynomials \f$c_i \in R_q\f$
@@ -66,6 +156,7 @@ typedef struct bgv_ct_t {
 
 ///
 /// \brief Initialize BGV scheme parameters
+/// The residues of q are all 1 mod t so that ciphertexts can switch levels.
 ///
 /// \param b BGV context
 /// \param lgd where d is the polynomial ring degree (power of 2)
@@ -77,6 +168,36 @@ typedef struct bgv_ct_t {
 ///
 int bgv_init(bgv_t *b, size_t lgd, size_t lgq, size_t lgm, size_t t);
 
+///
+/// \brief Initialize BGV scheme parameters with a given digit count
+/// More digits give smaller key switching noise and larger, slower
+/// evaluation keys. dnum is capped at the number of RNS limbs.
+///
+/// \param b BGV context
+/// \param lgd where d is the polynomial ring degree (power of 2)
+/// \param lgq the bitlength of the ciphertext modulus q
+/// \param lgm the bitlength of the residues in the CRT representation of q
+/// \param t the plaintext modulus
+/// \param dnum the number of key switching digits
+///
+/// \returns 0 on success, nonzero otherwise.
+///
+int bgv_init_dnum(bgv_t *b, size_t lgd, size_t lgq, size_t lgm, size_t t,
+                  size_t dnum);
+
+///
+/// \brief Initialize BGV scheme parameters over a ring saved by ring_save
+///
+/// \param b BGV context
+/// \param path Ring file, see ring_load
+/// \param t the plaintext modulus, every residue must be 1 mod t
+/// \param dnum the number of key switching digits
+///
+/// \returns 0 on success, -EINVAL if the file or t is not suitable,
+/// -errno on other failures.
+///
+int bgv_init_file(bgv_t *b, const char *path, size_t t, size_t dnum);
+
 ///
 /// \brief Generate a BGV key pair
 ///
@@ -87,7 +208,91 @@ int bgv_init(bgv_t *b, size_t lgd, size_t lgq, size_t lgm, size_t t);
 /// \param b BGV context
 /// \param [out] k generated key \f$ = (s, (e - as, a))\f$
 ///
-void bgv_keygen(const bgv_t *const b, bgv_key_t *k);
+/// \returns 0 on success, -errno if memory allocation fails.
+///
+int bgv_keygen(const bgv_t *const b, bgv_key_t *k);
+
+///
+/// \brief Generate a key from a deterministic generator
+///
+/// \param b BGV context
+/// \param [out] k generated key, a function of the state of g
+/// \param g Generator, or NULL for bgv_keygen
+///
+/// \returns 0 on success, -errno if memory allocation fails.
+///
+int bgv_keygen_rng(const bgv_t *const b, bgv_key_t *k, poly_rng_t *g);
+
+///
+/// \brief Initialize an empty key switching key
+///
+/// \param r Polynomial ring
+/// \param [out] k Key switching key without key pairs
+/// \param dnum Requested number of digits, capped at the number of limbs
+///
+/// \returns 0 on success, nonzero otherwise.
+///
+int bgv_ksk_init(const ring_t *const r, bgv_ksk_t *k, size_t dnum);
+
+///
+/// \brief Generate a key switching key
+///
+/// \param b BGV context
+/// \param [out] k Key switching key from from to s
+/// \param s Target secret key in NTT form
+/// \param from Source secret key in NTT form
+///
+/// \returns 0 on success, nonzero otherwise.
+///
+int bgv_ksk_gen(const bgv_t *const b, bgv_ksk_t *k, const poly_t *const s,
+                const poly_t *const from);
+
+///
+/// \brief Generate a key switching key from a deterministic generator
+///
+/// \param b BGV context
+/// \param [out] k Key switching key from from to s
+/// \param s Target secret key in NTT form
+/// \param from Source secret key in NTT form
+/// \param g Generator, or NULL for bgv_ksk_gen
+///
+/// \returns 0 on success, nonzero otherwise.
+///
+int bgv_ksk_gen_rng(const bgv_t *const b, bgv_ksk_t *k, const poly_t *const s,
+                    const poly_t *const from, poly_rng_t *g);
+
+///
+/// \brief Key switch a polynomial
+/// Adds an encryption of \f$x s'\f$ under \f$s\f$ to \f$(c_0, c_1)\f$.
+///
+/// \param k Key switching key from \f$s'\f$ to \f$s\f$
+/// \param [in,out] c0 Constant ciphertext term
+/// \param [in,out] c1 Linear ciphertext term
+/// \param x Polynomial in NTT form multiplying \f$s'\f$
+///
+/// \returns 0 on success, -errno on allocation failure with c0 and c1
+/// unchanged.
+///
+int bgv_keyswitch(const bgv_ksk_t *const k, poly_t *c0, poly_t *c1,
+                  const poly_t *const x);
+
+///
+/// \brief Destroy a key switching key
+///
+/// \param k Key switching key
+///
+void bgv_ksk_free(bgv_ksk_t *k);
+
+///
+/// \brief Size in bytes of a serialized BGV key
+/// The key holds \f$s\f$, the public \f$b\f$ and one \f$b_j\f$ per digit,
+/// \f$2 + dnum\f$ polynomials, plus the seeds of the uniform terms. With the
+/// default of one digit per limb that is \f$2 + n\f$ polynomials, about half
+/// of the \f$3 + 2n\f$ needed to store every \f$a_j\f$ as well.
+///
+/// \param k BGV key
+///
+size_t bgv_key_size(const bgv_key_t *const k);
 
 ///
 /// \brief Serialize a BGV key pair
@@ -104,8 +309,10 @@ void bgv_key_serialize(unsigned char *buf, const bgv_key_t *const k);
 /// \param [out] k Deserialized key pair
 /// \param buf Serialized key pair
 ///
-void bgv_key_deserialize(const ring_t *const r, bgv_key_t *k,
-                         const unsigned char *const buf);
+/// \returns 0 on success, -errno if memory allocation fails.
+///
+int bgv_key_deserialize(const ring_t *const r, bgv_key_t *k,
+                        const unsigned char *const buf);
 
 ///
 /// \brief Encrypt a polynomial using the BGV scheme
@@ -121,6 +328,118 @@ void bgv_key_deserialize(const ring_t *const r, bgv_key_t *k,
 void bgv_encrypt(const bgv_t *const b, bgv_ct_t *c,
                  const bgv_keypair_t *const k, const poly_t *const m);
 
+///
+/// \brief Encrypt a polynomial into an initialized ciphertext
+///
+/// \param b BGV context
+/// \param [out] c Ciphertext of length 2
+/// \param k BGV public key used for encryption
+/// \param m Plaintext message used for encryption
+///
+/// \returns 0 on success, -EINVAL if c is not of length 2.
+///
+int bgv_encrypt_into(const bgv_t *const b, bgv_ct_t *c,
+                     const bgv_keypair_t *const k, const poly_t *const m);
+
+///
+/// \brief Encrypt a polynomial with randomness from a generator
+///
+/// \param b BGV context
+/// \param [out] c Ciphertext of length 2
+/// \param k BGV public key used for encryption
+/// \param m Plaintext message used for encryption
+/// \param g Generator, or NULL for bgv_encrypt_into
+///
+/// \returns 0 on success, -EINVAL if c is not of length 2.
+///
+int bgv_encrypt_into_rng(const bgv_t *const b, bgv_ct_t *c,
+                         const bgv_keypair_t *const k, const poly_t *const m,
+                         poly_rng_t *g);
+
+///
+/// \brief Encrypt a polynomial under a secret key
+/// The ciphertext is \f$(m + t e - a s, a)\f$ with a expanded from a fresh
+/// seed, so it can be stored with bgv_ct_serialize_seeded.
+///
+/// \param b BGV context
+/// \param [out] c Resulting ciphertext
+/// \param s BGV secret key in NTT form
+/// \param m Plaintext message in NTT form
+/// \param [out] seed POLY_SEED_BYTES bytes from which a is expanded
+///
+/// \returns 0 on success, nonzero otherwise.
+///
+int bgv_encrypt_sym(const bgv_t *const b, bgv_ct_t *c, const poly_t *const s,
+                    const poly_t *const m, unsigned char *seed);
+
+///
+/// \brief Encrypt under a secret key with randomness from a generator
+///
+/// \param b BGV context
+/// \param [out] c Resulting ciphertext
+/// \param s BGV secret key in NTT form
+/// \param m Plaintext message in NTT form
+/// \param [out] seed POLY_SEED_BYTES bytes from which a is expanded
+/// \param g Generator, or NULL for bgv_encrypt_sym
+///
+/// \returns 0 on success, nonzero otherwise.
+///
+int bgv_encrypt_sym_rng(const bgv_t *const b, bgv_ct_t *c,
+                        const poly_t *const s, const poly_t *const m,
+                        unsigned char *seed, poly_rng_t *g);
+
+///
+/// \brief Initialize a pool of precomputed encryptions
+///
+/// \param b BGV context, must outlive the pool
+/// \param [out] p Encryption pool
+/// \param k BGV public key, must outlive the pool
+/// \param cap Maximum number of cached encryptions
+/// \param background Nonzero to keep the pool full from a worker thread
+///
+/// \returns 0 on success, nonzero otherwise.
+///
+int bgv_encpool_init(const bgv_t *const b, bgv_encpool_t *p,
+                     const bgv_keypair_t *const k, size_t cap, int background);
+
+///
+/// \brief Precompute encryptions in the calling thread
+///
+/// \param p Encryption pool
+/// \param n Number of encryptions to add, capped by the free room
+///
+/// \returns 0 on success, nonzero otherwise.
+///
+int bgv_encpool_fill(bgv_encpool_t *p, size_t n);
+
+///
+/// \brief Number of cached encryptions
+///
+/// \param p Encryption pool
+///
+size_t bgv_encpool_size(bgv_encpool_t *p);
+
+///
+/// \brief Encrypt a polynomial with a precomputed encryption of zero
+/// Each cached encryption is used once. An empty pool falls back to a
+/// regular encryption.
+///
+/// \param p Encryption pool
+/// \param [out] c Resulting ciphertext
+/// \param m Plaintext message in NTT form, e.g. from poly_encode
+///
+/// \returns 0 on success, nonzero otherwise.
+///
+int bgv_encrypt_pooled(bgv_encpool_t *p, bgv_ct_t *c, const poly_t *const m);
+
+///
+/// \brief Destroy an encryption pool
+/// Stops the worker thread and frees the cached encryptions.
+///
+/// \param p Encryption pool
+///
+void bgv_encpool_free(bgv_encpool_t *p);
+
 ///
 /// \brief Decrypt a BGV ciphertext
 ///
@@ -130,6 +449,18 @@ void bgv_encrypt(const bgv_t *const b, bgv_ct_t *c,
 ///
 void bgv_decrypt(poly_t *m, const bgv_ct_t *const c, const poly_t *const s);
 
+///
+/// \brief Decrypt a BGV ciphertext into an initialized polynomial
+///
+/// \param [out] m Resulting plaintext
+/// \param c BGV ciphertext to be decrypted
+/// \param s BGV secret key with which to decrypt
+///
+/// \returns 0 on success, -EINVAL if c is empty.
+///
+int bgv_decrypt_into(poly_t *m, const bgv_ct_t *const c,
+                     const poly_t *const s);
+
 ///
 /// \brief Destroy a BGV struct.
 /// Free any memory allocated by the context.
@@ -174,28 +505,191 @@ int bgv_ct_init(const ring_t *const r, bgv_ct_t *c, size_t n);
 
 ///
 /// \brief Add two BGV ciphertexts
+/// The ciphertexts may have different lengths, the missing polynomials of
+/// the shorter one are taken as zero.
 ///
 /// \param [out] c The encryption of a + b
 /// \param a BGV ciphertext addend
 /// \param b BGV ciphertext addend
 ///
+void bgv_ct_add(bgv_ct_t *c, const bgv_ct_t *const a, const bgv_ct_t *const b);
+
+///
+/// \brief Add two BGV ciphertexts into an initialized ciphertext
+///
+/// \param [out] c The encryption of a + b, as long as the longer input
+/// \param a BGV ciphertext addend
+/// \param b BGV ciphertext addend
+///
+/// \returns 0 on success, -EINVAL if c has the wrong length.
+///
 /// Note: Any of a, b, or c may overlap
 ///
-void bgv_ct_add(bgv_ct_t *c, const bgv_ct_t *const a, const bgv_ct_t *const b);
+int bgv_ct_add_into(bgv_ct_t *c, const bgv_ct_t *const a,
+                    const bgv_ct_t *const b);
+
+///
+/// \brief Subtract two BGV ciphertexts
+/// The ciphertexts may have different lengths.
+///
+/// \param [out] c The encryption of a - b
+/// \param a BGV ciphertext minuend
+/// \param b BGV ciphertext subtrahend
+///
+void bgv_ct_sub(bgv_ct_t *c, const bgv_ct_t *const a, const bgv_ct_t *const b);
+
+///
+/// \brief Subtract two BGV ciphertexts into an initialized ciphertext
+///
+/// \param [out] c The encryption of a - b, as long as the longer input
+/// \param a BGV ciphertext minuend
+/// \param b BGV ciphertext subtrahend
+///
+/// \returns 0 on success, -EINVAL if c has the wrong length.
+///
+/// Note: Any of a, b, or c may overlap
+///
+int bgv_ct_sub_into(bgv_ct_t *c, const bgv_ct_t *const a,
+                    const bgv_ct_t *const b);
+
+///
+/// \brief Encode a plaintext for repeated use
+///
+/// \param b BGV context
+/// \param [out] pt Encoded plaintext
+/// \param x d plaintext coefficients, taken mod t
+///
+void bgv_pt_encode(const bgv_t *const b, bgv_pt_t *pt, const uint_t *const x);
+
+///
+/// \brief Destroy an encoded plaintext
+///
+/// \param pt Encoded plaintext
+///
+void bgv_pt_free(bgv_pt_t *pt);
+
+///
+/// \brief Initialize the slot encoder of a BGV context
+///
+/// \param b BGV context
+/// \param [out] e Slot encoder
+///
+/// \returns 0 on success, -EINVAL if t is not a prime 1 mod 2d.
+///
+int bgv_batch_init(const bgv_t *const b, bgv_batch_t *e);
+
+///
+/// \brief Encode d slot values into a plaintext
+///
+/// \param b BGV context
+/// \param e Slot encoder of b
+/// \param [out] pt Encoded plaintext
+/// \param x d slot values, taken mod t
+///
+/// \returns 0 on success, nonzero otherwise.
+///
+int bgv_batch_encode(const bgv_t *const b, const bgv_batch_t *const e,
+                     bgv_pt_t *pt, const uint_t *const x);
+
+///
+/// \brief Decode the slot values of a plaintext
+///
+/// \param e Slot encoder
+/// \param [out] out d slot values in [0, t)
+/// \param m Plaintext in coefficient form, e.g. from bgv_decrypt
+///
+/// \returns 0 on success, nonzero otherwise.
+///
+int bgv_batch_decode(const bgv_batch_t *const e, uint_t *out,
+                     const poly_t *const m);
+
+///
+/// \brief Destroy a slot encoder
+///
+/// \param e Slot encoder
+///
+void bgv_batch_free(bgv_batch_t *e);
+
+///
+/// \brief Add a plaintext to a BGV ciphertext
+///
+/// \param [out] c Initialized ciphertext as long as x, the encryption of
+/// x + m. May alias x.
+/// \param x BGV ciphertext
+/// \param m Plaintext, e.g. from poly_encode or bgv_pt_encode. A plaintext
+/// in coefficient form is transformed on every call.
+///
+/// \returns 0 on success, -EINVAL if c has the wrong length.
+///
+int bgv_ct_add_plain(bgv_ct_t *c, const bgv_ct_t *const x,
+                     const poly_t *const m);
+
+///
+/// \brief Multiply a BGV ciphertext by a plaintext
+/// The product keeps the length of x and needs no relinearization, the
+/// noise grows with the norm of m.
+///
+/// \param [out] c Initialized ciphertext as long as x, the encryption of
+/// x * m. May alias x.
+/// \param x BGV ciphertext
+/// \param m Plaintext, e.g. from poly_encode or bgv_pt_encode
+///
+/// \returns 0 on success, -EINVAL if c has the wrong length.
+///
+int bgv_ct_mul_plain(bgv_ct_t *c, const bgv_ct_t *const x,
+                     const poly_t *const m);
+
+///
+/// \brief Multiply a BGV ciphertext by an integer
+///
+/// \param [out] c Initialized ciphertext as long as x, the encryption of
+/// s x. May alias x.
+/// \param x BGV ciphertext
+/// \param s Scalar, may be negative
+///
+/// \returns 0 on success, -EINVAL if c has the wrong length.
+///
+int bgv_ct_mul_scalar(bgv_ct_t *c, const bgv_ct_t *const x, int_t s);
 
 ///
 /// \brief Multiply two BGV ciphertexts
 ///
 /// \param [out] c The encryption of a * b
-/// \param e BGV evaluation key used for auto-relinearization
+/// \param e BGV evaluation key used for auto-relinearization, or NULL to
+/// keep the degree 2 ciphertext (n = 3) for a later bgv_ct_relin
 /// \param a BGV ciphertext addend
 /// \param b BGV ciphertext addend
 ///
+/// \returns 0 on success, -EINVAL unless a and b have length 2, -errno on
+/// allocation failure with c released.
+///
 /// Note: c will be overwritten by this function
 /// and SHOULD NOT overlap with neither the multiplier nor the multiplicand.
 ///
-void bgv_ct_mul(bgv_ct_t *c, const bgv_keypair_t *e, const bgv_ct_t *const a,
-                const bgv_ct_t *const b);
+int bgv_ct_mul(bgv_ct_t *c, const bgv_ksk_t *e, const bgv_ct_t *const a,
+               const bgv_ct_t *const b);
+
+///
+/// \brief Multiply two BGV ciphertexts into an initialized ciphertext
+/// A length 2 output is relinearized on the fly with a single temporary, a
+/// length 3 output receives the degree 2 product as is. Sums of such
+/// products can then be relinearized once with bgv_ct_relin.
+///
+/// \param [out] c Ciphertext of length 2 or 3, the encryption of a * b
+/// \param e BGV evaluation key used for relinearization, may be NULL for
+/// a length 3 output
+/// \param a BGV ciphertext multiplicand
+/// \param b BGV ciphertext multiplier
+///
+/// \returns 0 on success, -EINVAL on a length mismatch or a missing key,
+/// -errno if relinearization fails, in which case c is not an encryption
+/// of a * b.
+///
+/// Note: c SHOULD NOT overlap with neither the multiplier nor the
+/// multiplicand.
+///
+int bgv_ct_mul_into(bgv_ct_t *c, const bgv_ksk_t *e,
+                    const bgv_ct_t *const a, const bgv_ct_t *const b);
 
 ///
 /// \brief Relinearize a BGV ciphertext in place
@@ -203,9 +697,116 @@ void bgv_ct_mul(bgv_ct_t *c, const bgv_keypair_t *e, const bgv_ct_t *const a,
 /// \param [out] c The relinearized ciphertext
 /// \param k The relinierization key
 ///
+/// \returns 0 on success or if c already has length 2, -EINVAL for other
+/// lengths, -errno on allocation failure with c unchanged.
+///
 /// Note: c will be overwritten by this function.
 ///
-void bgv_ct_relin(bgv_ct_t *c, const bgv_keypair_t *const k);
+int bgv_ct_relin(bgv_ct_t *c, const bgv_ksk_t *const k);
+
+///
+/// \brief Level of a BGV ciphertext
+///
+/// \param c BGV ciphertext
+///
+/// \returns The number of modulus switches left, one less than the number
+/// of active RNS limbs.
+///
+size_t bgv_ct_level(const bgv_ct_t *const c);
+
+///
+/// \brief Switch a BGV ciphertext to the next level in place
+/// Scales c by \f$1 / m_l\f$ and drops the last active limb. Rounding
+/// adds a multiple of t, and every \f$m_l = 1\f$ mod t, so the
+/// plaintext is unchanged while the noise shrinks by \f$m_l\f$ down to
+/// the rounding term. All later operations run over fewer limbs.
+///
+/// \param b BGV context
+/// \param [in,out] c BGV ciphertext
+///
+/// \returns 0 on success, -EINVAL if c is at level 0.
+///
+int bgv_ct_modswitch(const bgv_t *const b, bgv_ct_t *c);
+
+///
+/// \brief Galois element of a rotation
+/// Rotations by step use \f$g = 3^{step}\f$ mod 2d, negative steps rotate
+/// the other way. The element 2d - 1 is the complementary automorphism.
+///
+/// \param r Polynomial ring
+/// \param step Rotation step
+///
+size_t bgv_galois_elt(const ring_t *const r, long step);
+
+///
+/// \brief Generate Galois keys
+///
+/// \param b BGV context
+/// \param [out] gk Galois keys
+/// \param k BGV key
+/// \param g Odd Galois elements, see bgv_galois_elt
+/// \param n Number of elements
+///
+/// \returns 0 on success, -EINVAL on an even element, -errno otherwise.
+///
+int bgv_galois_keygen(const bgv_t *const b, bgv_galois_t *gk,
+                      const bgv_key_t *const k, const size_t *const g,
+                      size_t n);
+
+///
+/// \brief Apply an automorphism to a BGV ciphertext in place
+/// Turns an encryption of \f$m(x)\f$ into an encryption of \f$m(x^g)\f$.
+///
+/// \param gk Galois keys holding element g
+/// \param [in,out] c BGV ciphertext of length 2
+/// \param g Galois element
+///
+/// \returns 0 on success, -EINVAL on a missing key or a wrong length.
+///
+int bgv_ct_automorph(const bgv_galois_t *const gk, bgv_ct_t *c, size_t g);
+
+///
+/// \brief Rotate a BGV ciphertext in place
+///
+/// \param gk Galois keys holding bgv_galois_elt(r, step)
+/// \param [in,out] c BGV ciphertext of length 2
+/// \param step Rotation step
+///
+/// \returns 0 on success, -EINVAL on a missing key or a wrong length.
+///
+int bgv_ct_rotate(const bgv_galois_t *const gk, bgv_ct_t *c, long step);
+
+///
+/// \brief Rotate a BGV ciphertext by several steps
+/// The gadget decomposition of \f$c_1\f$ is computed once and shared by
+/// all steps, each extra step costs a permutation and an inner product.
+///
+/// \param gk Galois keys holding every step
+/// \param [out] out n ciphertexts, out[i] is c rotated by steps[i]
+/// \param c BGV ciphertext of length 2
+/// \param steps Rotation steps
+/// \param n Number of steps
+///
+/// \returns 0 on success, -EINVAL on a missing key or a wrong length.
+///
+int bgv_ct_rotate_hoisted(const bgv_galois_t *const gk, bgv_ct_t *out,
+                          const bgv_ct_t *const c, const long *const steps,
+                          size_t n);
+
+///
+/// \brief Destroy Galois keys
+///
+/// \param gk Galois keys
+///
+void bgv_galois_free(bgv_galois_t *gk);
+
+///
+/// \brief Size in bytes of a serialized BGV ciphertext
+/// Only the limbs of the current level are stored.
+///
+/// \param c BGV ciphertext
+///
+size_t bgv_ct_size(const bgv_ct_t *const c);
 
 ///
 /// \brief Serialize a BGV ciphertext into a byte stream
@@ -222,8 +823,45 @@ void bgv_ct_serialize(unsigned char *buf, const bgv_ct_t *const c);
 /// \param [out] c Deserialized ciphertext
 /// \param buf Serialized ciphertext byte stream
 ///
-void bgv_ct_deserialize(const ring_t *const r, bgv_ct_t *c,
-                        const unsigned char *buf);
+/// \returns 0 on success, -EINVAL on a seeded byte stream or a header with
+/// an invalid polynomial or limb count, -errno if memory allocation fails.
+///
+int bgv_ct_deserialize(const ring_t *const r, bgv_ct_t *c,
+                       const unsigned char *buf);
+
+///
+/// \brief Size in bytes of a serialized seeded BGV ciphertext
+///
+/// \param c BGV ciphertext
+///
+size_t bgv_ct_seeded_size(const bgv_ct_t *const c);
+
+///
+/// \brief Serialize a fresh secret key encryption, storing the seed of
+/// \f$c_1\f$ instead of \f$c_1\f$
+///
+/// \param [out] buf Serialized ciphertext byte stream
+/// \param c Unmodified ciphertext from bgv_encrypt_sym
+/// \param seed Seed returned by bgv_encrypt_sym
+///
+/// \returns 0 on success, -EINVAL if c is not a fresh ciphertext or its
+/// \f$c_1\f$ no longer expands from seed, -errno if memory allocation fails.
+///
+int bgv_ct_serialize_seeded(unsigned char *buf, const bgv_ct_t *const c,
+                            const unsigned char *const seed);
+
+///
+/// \brief Deserialize a seeded BGV ciphertext, expanding \f$c_1\f$
+///
+/// \param r Polynomial ring
+/// \param [out] c Deserialized ciphertext
+/// \param buf Serialized ciphertext byte stream
+///
+/// \returns 0 on success, -EINVAL if buf is not a seeded ciphertext of r or
+/// -errno if memory allocation fails.
+///
+int bgv_ct_deserialize_seeded(const ring_t *const r, bgv_ct_t *c,
+                              const unsigned char *buf);
 
 ///
 /// \brief Destroy a BGV ciphertext
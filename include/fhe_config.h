@@ -64,7 +64,8 @@ typedef __uint128_t uint_dt;
 typedef enum DISTRIBUTION {
   UNIFORM = 0,
   TERNARY,
-  ERR,
+  ERR,     ///< Discrete Gaussian by rejection sampling
+  ERR_CDT, ///< The same discrete Gaussian from a constant time table
 } DISTRIBUTION;
 
 #endif /* FHE_CONFIG_H */
@@ -27,6 +27,25 @@
 
 #include "fhe_ring.h"
 
+///
+/// \brief Length in bytes of the seed of poly_expand
+///
+#define POLY_SEED_BYTES 32
+
+///
+/// \brief Deterministic random generator for polynomials
+///
+/// Every polynomial drawn from the generator takes the next nonce and is
+/// a pure function of the seed and that nonce. Coefficients are read at
+/// fixed positions of ChaCha20 streams, so they do not depend on how the
+/// work is split among threads, and threads may share a generator.
+/// Storing a previous nonce replays the polynomials drawn from it.
+///
+typedef struct poly_rng_t {
+  unsigned char seed[POLY_SEED_BYTES]; ///< Key of every stream
+  uint32_t nonce;                      ///< Nonce of the next polynomial
+} poly_rng_t;
+
 ///
 /// \brief Main Polynomial type used to represent polynomials
 /// over \f$R = Z_M[X] / <x^d + 1>\f$ for a generic modulus \f$M\f$.
@@ -41,10 +60,14 @@
 /// Residues \f$m_i\f$ are pairwise coprime word-sized integers (typically
 /// between 32-60 bits)
 ///
+/// Only the first n residues are active, after limbs are dropped by
+/// poly_rescale the polynomial lives mod \f$m_0 \cdots m_{n-1}\f$. Binary
+/// operations run over the limbs active in all operands.
 ///
 typedef struct poly_t {
   ring_t *r;   ///< Reference to the base ring
   uint_t *b;   ///< Polynomial coefficients
+  size_t n;    ///< Number of active residues
   char is_ntt; ///< Boolean Flag marks whether the polynomial is
                ///< in coefficient or evaluation form
 } poly_t;
@@ -66,14 +89,43 @@ int poly_zero(const ring_t *const r, poly_t *p);
 ///
 void poly_encode(const ring_t *const r, const uint_t *const u, poly_t *p);
 
+///
+/// \brief Encode a polynomial with coefficients mod t
+/// Coefficients are lifted to (-t/2, t/2] before the CRT decomposition,
+/// which keeps products with ciphertexts small.
+///
+/// \param r Underlying ring
+/// \param u Polynomial coefficients
+/// \param t Coefficient modulus
+/// \param [out] p Encoded polynomial in NTT form
+///
+void poly_encode_mod(const ring_t *const r, const uint_t *const u, uint_t t,
+                     poly_t *p);
+
 ///
 /// \brief Decode a polynomial into its original form
+/// The coefficients are lifted to \f$(-M/2, M/2]\f$ and reduced mod t
+/// without multiprecision arithmetic. The rounding of the lift is done in
+/// double precision, it is exact unless a coefficient lies within about
+/// \f$n 2^{-52} M\f$ of \f$\pm M/2\f$.
+///
+/// \param [out] out decoded polynomial
+/// \param p encoded polynomial
+/// \param t modulus, below 2^63
+///
+/// \returns 0 on success, -errno if memory allocation fails.
+///
+int poly_decode(uint_t *out, const poly_t *const p, uint_t t);
+
+///
+/// \brief Decode a polynomial with multiprecision CRT reconstruction
+/// Slower reference for poly_decode, exact for every coefficient.
 ///
 /// \param [out] out decoded polynomial
 /// \param p encoded polynomial
 /// \param t modulus
 ///
-void poly_decode(uint_t *out, const poly_t *const p, uint_t t);
+void poly_decode_mp(uint_t *out, const poly_t *const p, uint_t t);
 
 ///
 /// \brief Convert to NTT form
@@ -89,6 +141,25 @@ void poly_ntt(poly_t *p);
 ///
 void poly_intt(poly_t *p);
 
+///
+/// \brief Convert a batch of polynomials to NTT form
+///
+/// All residues of all polynomials are transformed in a single parallel
+/// region. Polynomials already in NTT form are left untouched.
+///
+/// \param p Polynomials over the same ring
+/// \param k Number of polynomials
+///
+void poly_ntt_batch(poly_t *const *p, size_t k);
+
+///
+/// \brief Convert a batch of polynomials back from NTT form
+///
+/// \param p Polynomials over the same ring
+/// \param k Number of polynomials
+///
+void poly_intt_batch(poly_t *const *p, size_t k);
+
 ///
 /// \brief Clone a polynomial
 ///
@@ -97,6 +168,14 @@ void poly_intt(poly_t *p);
 ///
 void poly_clone(poly_t *dst, const poly_t *const src);
 
+///
+/// \brief Copy a polynomial into an initialized polynomial
+///
+/// \param [out] dst Destination polynomial over the same ring
+/// \param src Source polynomial
+///
+void poly_copy(poly_t *dst, const poly_t *const src);
+
 ///
 /// \brief Constant multiplication
 ///
@@ -106,8 +185,42 @@ void poly_clone(poly_t *dst, const poly_t *const src);
 ///
 void poly_cmul(poly_t *out, const poly_t *const in, int_t c);
 
+///
+/// \brief Multiplication by a constant given by its CRT residues
+///
+/// \param [out] out Resulting polynomial
+/// \param in Input polynomial
+/// \param c Residues of the constant, one per ring modulus, each reduced
+///
+void poly_cmul_rns(poly_t *out, const poly_t *const in, const uint_t *const c);
+
+///
+/// \brief Apply the automorphism \f$p(x) \mapsto p(x^g)\f$
+/// In NTT form this is a permutation of the evaluations.
+///
+/// \param [out] out Resulting polynomial, disjoint from in
+/// \param in Input polynomial
+/// \param g Odd exponent, taken mod 2d
+///
+void poly_automorph(poly_t *out, const poly_t *const in, size_t g);
+
+///
+/// \brief Divide by the last active residue and drop it
+/// Computes \f$(p - \delta) / m_{n-1}\f$ where \f$\delta = p\f$ mod
+/// \f$m_{n-1}\f$ and \f$\delta = 0\f$ mod t, with \f$|\delta| \le t
+/// m_{n-1} / 2\f$. With t = 1 this is a rounded division.
+///
+/// \param p Polynomial with at least two active residues
+/// \param t Modulus of the rounding
+///
+/// \returns 0 on success, -EINVAL if p has a single residue left.
+///
+int poly_rescale(poly_t *p, uint_t t);
+
 ///
 /// \brief Sample a random polynomial
+/// UNIFORM draws every residue uniformly mod \f$m_i\f$. TERNARY and ERR
+/// draw one small integer polynomial and reduce it into every residue.
 ///
 /// \param r Base ring
 /// \param [out] out Random polynomial
@@ -115,6 +228,54 @@ void poly_cmul(poly_t *out, const poly_t *const in, int_t c);
 ///
 void poly_rand(const ring_t *const r, poly_t *out, DISTRIBUTION d);
 
+///
+/// \brief Expand a seed into a uniform polynomial
+/// Residue i is drawn from ChaCha20 keyed by the seed with nonce (i, idx),
+/// by rejection sampling mod \f$m_i\f$. The same seed and index always
+/// give the same polynomial, which is taken to be in NTT form.
+///
+/// \param r Base ring
+/// \param [out] out Uniform polynomial in NTT form
+/// \param seed POLY_SEED_BYTES bytes of seed
+/// \param idx Index of the polynomial among those of the seed
+///
+/// \returns 0 on success, -errno if memory allocation fails.
+///
+int poly_expand(const ring_t *const r, poly_t *out,
+                const unsigned char *const seed, uint32_t idx);
+
+///
+/// \brief Initialize a deterministic random generator
+///
+/// \param [out] g Generator at nonce 0
+/// \param seed POLY_SEED_BYTES bytes of seed, or NULL for a fresh one
+///
+void poly_rng_init(poly_rng_t *g, const unsigned char *const seed);
+
+///
+/// \brief Draw random bytes, such as seeds for poly_expand
+///
+/// \param g Generator, or NULL for the thread local one
+/// \param [out] buf Random bytes
+/// \param len Number of bytes
+///
+void poly_rng_bytes(poly_rng_t *g, unsigned char *buf, size_t len);
+
+///
+/// \brief Sample a random polynomial from a generator
+/// Residue i of a UNIFORM polynomial reads two words per coefficient from
+/// stream (i, nonce), scaled to \f$[0, m_i)\f$ within \f$2^{-64}\f$ of
+/// uniform. Small polynomials read one word per coefficient from stream
+/// (0, nonce), and ERR is drawn as ERR_CDT.
+///
+/// \param r Base ring
+/// \param [out] out Random polynomial
+/// \param d Sampling distribution
+/// \param g Generator, or NULL to fall back to poly_rand
+///
+void poly_rand_rng(const ring_t *const r, poly_t *out, DISTRIBUTION d,
+                   poly_rng_t *g);
+
 ///
 /// \brief Negate a polynomial
 ///
@@ -148,6 +309,63 @@ void poly_sub(poly_t *c, const poly_t *const a, const poly_t *const b);
 ///
 void poly_mul(poly_t *c, const poly_t *const a, const poly_t *const b);
 
+///
+/// \brief Fused multiply-accumulate c = c + a * b
+///
+/// \param [in,out] c Accumulator
+/// \param a multiplicand
+/// \param b multiplier
+///
+void poly_fma(poly_t *c, const poly_t *const a, const poly_t *const b);
+
+///
+/// \brief Fused multiply-add d = a * b + c
+/// The output may alias any of the inputs.
+///
+/// \param [out] d Result
+/// \param a multiplicand
+/// \param b multiplier
+/// \param c Addend
+///
+void poly_mul_add(poly_t *d, const poly_t *const a, const poly_t *const b,
+                  const poly_t *const c);
+
+///
+/// \brief Fused multiply-subtract d = c - a * b
+/// The output may alias any of the inputs.
+///
+/// \param [out] d Result
+/// \param a multiplicand
+/// \param b multiplier
+/// \param c Minuend
+///
+void poly_mul_sub(poly_t *d, const poly_t *const a, const poly_t *const b,
+                  const poly_t *const c);
+
+///
+/// \brief Degree 2 tensor product of two linear polynomials
+/// Computes (x0 + x1 X) * (y0 + y1 X) = c0 + c1 X + c2 X^2 in a single pass
+/// with three multiplications per coefficient (Karatsuba).
+///
+/// \param [out] c Three polynomials c0, c1, c2, disjoint from x and y
+/// \param x Two polynomials x0, x1
+/// \param y Two polynomials y0, y1
+///
+void poly_tensor(poly_t *c, const poly_t *const x, const poly_t *const y);
+
+///
+/// \brief Inner product out = sum a[i] * b[i]
+/// Products are accumulated unreduced in 128 bits and reduced once per
+/// coefficient. The output may alias any of the inputs.
+///
+/// \param [out] out Resulting polynomial
+/// \param a Multiplicands
+/// \param b Multipliers
+/// \param k Number of products
+///
+void poly_dot(poly_t *out, const poly_t *const *a, const poly_t *const *b,
+              size_t k);
+
 ///
 /// \brief Serialize a polynomial into a byte stream
 ///
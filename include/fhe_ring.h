@@ -32,31 +32,90 @@
 /// \brief Main Ring type used to define a polynomial ring
 ///
 typedef struct ring_t {
-  size_t lgd;     ///< log d where d is the polynomial degree
-  size_t d;       ///< Polynomial degree
-  size_t n;       ///< Number of residues in the CRT representation of M
-  mpz_t M;        ///< Multiprecision representation of M
-  mpz_t M_half;   ///< Multiprecision representation of M/2
-  mpz_t *ms;      ///< M/m_i for each CRT residue m_i
-  uint_t *roots;  ///< Primitive roots of unity
-  uint_t *iroots; ///< Inverse primitive roots of unity
-  uint_t *invms;  ///< [M / m_i]_{m_i}^-1
-  uint_t *m;      ///< CRT decomposition of M
-  uint_t *minv;   ///< [m_i]^-1
-  uint_t *dinv;   ///< [d]_{m_i}^-1
+  size_t lgd;           ///< log d where d is the polynomial degree
+  size_t d;             ///< Polynomial degree
+  size_t n;             ///< Number of residues in the CRT representation of M
+  mpz_t M;              ///< Multiprecision representation of M
+  mpz_t M_half;         ///< Multiprecision representation of M/2
+  mpz_t *ms;            ///< M/m_i for each CRT residue m_i
+  uint_t *roots;        ///< Primitive roots of unity
+  uint_t *roots_shoup;  ///< floor(roots * 2^64 / m_i)
+  uint_t *iroots;       ///< Inverse primitive roots of unity
+  uint_t *iroots_shoup; ///< floor(iroots * 2^64 / m_i)
+  uint_t *invms;        ///< [M / m_i]_{m_i}^-1
+  uint_t *m;            ///< CRT decomposition of M
+  uint_t *minv;         ///< [m_i]^-1
+  uint_t *barrett;      ///< floor(2^2L / m_i) with L the bit length of m_i
+  uint_t *dinv;         ///< [d]_{m_i}^-1
+  uint_t *dinv_shoup;   ///< floor(dinv * 2^64 / m_i)
+  void *pool;           ///< Coefficient buffer pool, NULL if disabled
+  void *map;            ///< Mapped ring file holding the tables, if any
+  size_t map_len;       ///< Length of the mapping
 } ring_t;
 
+///
+/// \brief Buffer pool statistics
+///
+typedef struct ring_pool_stats_t {
+  size_t hits;   ///< Allocations served from the pool
+  size_t misses; ///< Allocations served from the heap
+  size_t cached; ///< Buffers currently held by the pool
+} ring_pool_stats_t;
+
 ///
 /// \brief Initialize a polynomial ring
 ///
 /// \param [out] r The polynomial ring
 /// \param lgd The bit length of the polynomial degree
 /// \param lgq The bit length of the base ring modulus
-/// \param lgm The bit length of the CRT residues
+/// \param lgm The bit length of the CRT residues (at most 60)
 ///
 ///
 int ring_init(ring_t *r, size_t lgd, size_t lgq, size_t lgm);
 
+///
+/// \brief Initialize a polynomial ring whose residues are all 1 mod t
+/// Dividing by such a residue leaves values mod t unchanged, which lets
+/// BGV ciphertexts drop limbs without rescaling the plaintext.
+///
+/// \param [out] r The polynomial ring
+/// \param lgd The bit length of the polynomial degree
+/// \param lgq The bit length of the base ring modulus
+/// \param lgm The bit length of the CRT residues (at most 60)
+/// \param t Modulus the residues are congruent to 1 for
+///
+/// \returns 0 on success, -EINVAL if lgm exceeds 60 or lcm(2d, t) does not
+/// fit in lgm bits.
+///
+int ring_init_congruent(ring_t *r, size_t lgd, size_t lgq, size_t lgm,
+                        uint_t t);
+
+///
+/// \brief Save a polynomial ring to a file
+/// The file holds the residues with their constants, M and the root
+/// tables, laid out so that ring_load maps it back without computation.
+///
+/// \param r Polynomial ring
+/// \param path File name
+///
+/// \returns 0 on success, -errno on failure.
+///
+int ring_save(const ring_t *const r, const char *path);
+
+///
+/// \brief Load a polynomial ring saved by ring_save
+/// The format version, byte order, size, checksum and residues of the
+/// file are checked, then its tables are used in place from a read only
+/// mapping until ring_free.
+///
+/// \param [out] r The polynomial ring
+/// \param path File name
+///
+/// \returns 0 on success, -EINVAL if the file does not hold a valid ring,
+/// -errno on other failures.
+///
+int ring_load(ring_t *r, const char *path);
+
 ///
 /// \brief Destroy a polynomial ring
 /// Free any memory allocated by the polynomial ring
@@ -65,4 +124,23 @@ int ring_init(ring_t *r, size_t lgd, size_t lgq, size_t lgm);
 ///
 void ring_free(ring_t *r);
 
+///
+/// \brief Enable the coefficient buffer pool of a ring
+/// Polynomials of the ring then recycle their buffers instead of returning
+/// them to the heap. The pool is thread safe and released by ring_free,
+/// so all polynomials must be freed before their ring.
+///
+/// \param r Polynomial ring
+/// \param cap Maximum number of cached buffers
+///
+int ring_pool_init(ring_t *r, size_t cap);
+
+///
+/// \brief Get the buffer pool statistics of a ring
+///
+/// \param r Polynomial ring
+/// \param [out] st Pool statistics, all zero if the pool is disabled
+///
+void ring_pool_stats(const ring_t *const r, ring_pool_stats_t *st);
+
 #endif /* FHE_RING_H */
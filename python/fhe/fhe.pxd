@@ -14,7 +14,7 @@
 # along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 from libc.stddef cimport size_t
-from libc.stdint cimport int64_t, uint64_t
+from libc.stdint cimport int64_t, uint32_t, uint64_t
 from gmpy2 cimport *
 
 import_gmpy2()
@@ -28,70 +28,184 @@ cdef extern from "fhe.h":
         mpz_t M_half
         mpz_t *ms
         uint64_t *roots
+        uint64_t *roots_shoup
         uint64_t *iroots
+        uint64_t *iroots_shoup
         uint64_t *invms
         uint64_t *m
         uint64_t *minv
+        uint64_t *barrett
         uint64_t *dinv
+        uint64_t *dinv_shoup
+        void *pool
+        void *map
+        size_t map_len
+
+    ctypedef struct ring_pool_stats_t:
+        size_t hits
+        size_t misses
+        size_t cached
 
     int ring_init(ring_t *, size_t lgd, size_t lgq, size_t lgm)
+    int ring_init_congruent(ring_t *, size_t lgd, size_t lgq, size_t lgm, uint64_t t)
+    int ring_save(ring_t *r, const char *path)
+    int ring_load(ring_t *r, const char *path)
+    int ring_pool_init(ring_t *, size_t cap)
+    void ring_pool_stats(const ring_t *, ring_pool_stats_t *)
     void ring_free(ring_t *r)
 
 cdef extern from "fhe.h":
+    enum: POLY_SEED_BYTES
+
     ctypedef struct poly_t:
         int64_t *b
         ring_t *r
+        size_t n
         char is_ntt
 
+    ctypedef struct poly_rng_t:
+        unsigned char seed[32]
+        uint32_t nonce
+
     int poly_zero(ring_t *r, poly_t *p)
     void poly_encode(ring_t *r, uint64_t *u, poly_t *p)
-    void poly_decode(uint64_t *out, poly_t *p, uint64_t t)
+    int poly_decode(uint64_t *out, poly_t *p, uint64_t t)
+    void poly_decode_mp(uint64_t *out, poly_t *p, uint64_t t)
+    void poly_encode_mod(ring_t *r, uint64_t *u, uint64_t t, poly_t *p)
     void poly_ntt(poly_t *p)
     void poly_intt(poly_t *p)
+    void poly_ntt_batch(poly_t **p, size_t k)
+    void poly_intt_batch(poly_t **p, size_t k)
     void poly_clone(poly_t *dst, poly_t *src)
+    void poly_copy(poly_t *dst, poly_t *src)
     void poly_cmul(poly_t *out, poly_t *in_, int64_t c)
     void poly_neg(poly_t *p)
+    int poly_rescale(poly_t *p, uint64_t t)
+    void poly_automorph(poly_t *out, poly_t *in_, size_t g)
+    int poly_expand(ring_t *r, poly_t *out, unsigned char *seed, uint32_t idx)
+    void poly_rng_init(poly_rng_t *g, unsigned char *seed)
+    void poly_rng_bytes(poly_rng_t *g, unsigned char *buf, size_t len)
     void poly_add(poly_t *c, poly_t *a, poly_t *b)
     void poly_sub(poly_t *c, poly_t *a, poly_t *b)
     void poly_mul(poly_t *c, poly_t *a, poly_t *b)
+    void poly_fma(poly_t *c, poly_t *a, poly_t *b)
+    void poly_mul_add(poly_t *d, poly_t *a, poly_t *b, poly_t *c)
+    void poly_mul_sub(poly_t *d, poly_t *a, poly_t *b, poly_t *c)
+    void poly_tensor(poly_t *c, poly_t *x, poly_t *y)
+    void poly_dot(poly_t *out, const poly_t **a, const poly_t **b, size_t k)
     int poly_cmp(poly_t *a, poly_t *b);
     void poly_free(poly_t *p)
 
 cdef extern from "fhe.h":
     ctypedef struct bgv_t:
         size_t t
+        size_t dnum
         ring_t r
 
     ctypedef struct bgv_keypair_t:
         poly_t a
         poly_t b
 
+    ctypedef struct bgv_ksk_t:
+        size_t dnum
+        size_t alpha
+        bgv_keypair_t *k
+        uint64_t *tab
+        unsigned char seed[32]
+
     ctypedef struct bgv_key_t:
         poly_t s
         bgv_keypair_t pub
-        bgv_keypair_t eval
+        bgv_ksk_t eval
+        unsigned char seed[32]
+
+    ctypedef struct bgv_pt_t:
+        poly_t p
+
+    ctypedef struct bgv_galois_t:
+        size_t n
+        size_t *g
+        bgv_ksk_t *k
+
+    ctypedef struct bgv_batch_t:
+        uint64_t t
+        size_t lgd
+        uint64_t *roots
+        uint64_t *roots_shoup
+        uint64_t *iroots
+        uint64_t *iroots_shoup
+        uint64_t dinv
+        uint64_t dinv_shoup
+        size_t *slot
+
+    ctypedef struct bgv_encpool_t:
+        void *state
 
     ctypedef struct bgv_ct_t:
         size_t n
         poly_t *c
 
     int bgv_init(bgv_t *b, size_t lgd, size_t lgq, size_t lgm, size_t t)
+    int bgv_init_dnum(bgv_t *b, size_t lgd, size_t lgq, size_t lgm, size_t t, size_t dnum)
+    int bgv_init_file(bgv_t *b, const char *path, size_t t, size_t dnum)
     void bgv_free(bgv_t *b)
 
-    void bgv_keygen(bgv_t *b, bgv_key_t *k)
+    int bgv_keygen(bgv_t *b, bgv_key_t *k)
+    int bgv_keygen_rng(bgv_t *b, bgv_key_t *k, poly_rng_t *g)
     void bgv_key_zero(ring_t *r, bgv_key_t *k);
+    int bgv_ksk_init(ring_t *r, bgv_ksk_t *k, size_t dnum)
+    int bgv_ksk_gen(bgv_t *b, bgv_ksk_t *k, poly_t *s, poly_t *src)
+    int bgv_ksk_gen_rng(bgv_t *b, bgv_ksk_t *k, poly_t *s, poly_t *src, poly_rng_t *g)
+    int bgv_keyswitch(bgv_ksk_t *k, poly_t *c0, poly_t *c1, poly_t *x)
+    void bgv_ksk_free(bgv_ksk_t *k)
+    size_t bgv_key_size(bgv_key_t *k)
     void bgv_key_serialize(unsigned char *buf, bgv_key_t *k)
-    void bgv_key_deserialize(ring_t *r, bgv_key_t *k, unsigned char *buf)
+    int bgv_key_deserialize(ring_t *r, bgv_key_t *k, unsigned char *buf)
     void bgv_encrypt(bgv_t *b, bgv_ct_t *c, bgv_keypair_t *k, poly_t *m)
     void bgv_decrypt(poly_t *m, bgv_ct_t *c, poly_t *s)
+    int bgv_encrypt_into(bgv_t *b, bgv_ct_t *c, bgv_keypair_t *k, poly_t *m)
+    int bgv_encrypt_into_rng(bgv_t *b, bgv_ct_t *c, bgv_keypair_t *k, poly_t *m, poly_rng_t *g)
+    int bgv_encpool_init(bgv_t *b, bgv_encpool_t *p, bgv_keypair_t *k, size_t cap, int background)
+    int bgv_encpool_fill(bgv_encpool_t *p, size_t n)
+    size_t bgv_encpool_size(bgv_encpool_t *p)
+    int bgv_encrypt_pooled(bgv_encpool_t *p, bgv_ct_t *c, poly_t *m)
+    void bgv_encpool_free(bgv_encpool_t *p)
+    int bgv_decrypt_into(poly_t *m, bgv_ct_t *c, poly_t *s)
     int bgv_key_cmp(bgv_key_t* a, bgv_key_t* b)
     void bgv_key_free(bgv_key_t *k)
 
     int bgv_ct_init(ring_t *r, bgv_ct_t *c, size_t n)
     void bgv_ct_add(bgv_ct_t *c, bgv_ct_t *a, bgv_ct_t *b)
-    void bgv_ct_mul(bgv_ct_t *c, bgv_keypair_t *e, bgv_ct_t *a, bgv_ct_t *b)
-    void bgv_ct_relin(bgv_ct_t *c, bgv_keypair_t *k)
+    int bgv_ct_mul(bgv_ct_t *c, bgv_ksk_t *e, bgv_ct_t *a, bgv_ct_t *b)
+    int bgv_ct_add_into(bgv_ct_t *c, bgv_ct_t *a, bgv_ct_t *b)
+    void bgv_ct_sub(bgv_ct_t *c, bgv_ct_t *a, bgv_ct_t *b)
+    int bgv_ct_sub_into(bgv_ct_t *c, bgv_ct_t *a, bgv_ct_t *b)
+    int bgv_ct_mul_into(bgv_ct_t *c, bgv_ksk_t *e, bgv_ct_t *a, bgv_ct_t *b)
+    int bgv_ct_relin(bgv_ct_t *c, bgv_ksk_t *k)
+    void bgv_pt_encode(bgv_t *b, bgv_pt_t *pt, uint64_t *x)
+    void bgv_pt_free(bgv_pt_t *pt)
+    int bgv_batch_init(bgv_t *b, bgv_batch_t *e)
+    int bgv_batch_encode(bgv_t *b, bgv_batch_t *e, bgv_pt_t *pt, uint64_t *x)
+    int bgv_batch_decode(bgv_batch_t *e, uint64_t *out, poly_t *m)
+    void bgv_batch_free(bgv_batch_t *e)
+    int bgv_ct_add_plain(bgv_ct_t *c, bgv_ct_t *x, poly_t *m)
+    int bgv_ct_mul_plain(bgv_ct_t *c, bgv_ct_t *x, poly_t *m)
+    int bgv_ct_mul_scalar(bgv_ct_t *c, bgv_ct_t *x, int64_t s)
+    size_t bgv_ct_level(bgv_ct_t *c)
+    int bgv_ct_modswitch(bgv_t *b, bgv_ct_t *c)
+    size_t bgv_ct_size(bgv_ct_t *c)
+    size_t bgv_galois_elt(ring_t *r, long step)
+    int bgv_galois_keygen(bgv_t *b, bgv_galois_t *gk, bgv_key_t *k, size_t *g, size_t n)
+    int bgv_ct_automorph(bgv_galois_t *gk, bgv_ct_t *c, size_t g)
+    int bgv_ct_rotate(bgv_galois_t *gk, bgv_ct_t *c, long step)
+    int bgv_ct_rotate_hoisted(bgv_galois_t *gk, bgv_ct_t *out, bgv_ct_t *c, long *steps, size_t n)
+    void bgv_galois_free(bgv_galois_t *gk)
     void bgv_ct_serialize(unsigned char *buf, bgv_ct_t *c);
-    void bgv_ct_deserialize(ring_t *r, bgv_ct_t *c, unsigned char *buf)
+    int bgv_ct_deserialize(ring_t *r, bgv_ct_t *c, unsigned char *buf)
+    int bgv_encrypt_sym(bgv_t *b, bgv_ct_t *c, poly_t *s, poly_t *m, unsigned char *seed)
+    int bgv_encrypt_sym_rng(bgv_t *b, bgv_ct_t *c, poly_t *s, poly_t *m, unsigned char *seed, poly_rng_t *g)
+    size_t bgv_ct_seeded_size(bgv_ct_t *c)
+    int bgv_ct_serialize_seeded(unsigned char *buf, bgv_ct_t *c, unsigned char *seed)
+    int bgv_ct_deserialize_seeded(ring_t *r, bgv_ct_t *c, unsigned char *buf)
     void bgv_ct_serialize(unsigned char *buf, bgv_ct_t *c)
     void bgv_ct_free(bgv_ct_t *c)
@@ -127,7 +127,8 @@ cdef class Poly:
     def decode(self, modulus):
         d = int(self._ptr.r.d)
         cdef cnp.uint64_t[:] a = np.zeros(d, dtype=np.uint64, order="C")
-        poly_decode(&a[0], self._ptr, modulus)
+        if poly_decode(&a[0], self._ptr, modulus):
+            raise MemoryError
         return a
 
     def ntt(self):
@@ -164,7 +165,9 @@ cdef class BGVKey:
 
     @property
     def eval(self):
-        return (Poly.from_ptr(&self.k.eval.a, False), Poly.from_ptr(&self.k.eval.b, False))
+        return [(Poly.from_ptr(&self.k.eval.k[j].a, False),
+                 Poly.from_ptr(&self.k.eval.k[j].b, False))
+                for j in range(self.k.eval.dnum)]
 
     def encrypt(self, cnp.ndarray[uint64_t, mode="c"] pt not None):
         if len(pt) != int(self.b.r.d):
@@ -190,8 +193,7 @@ cdef class BGVKey:
         return CipherText.from_ptr(ct, &self.k.eval, True)
 
     def bytes(self):
-        cdef ring_t* r = <ring_t*>&self.b.r
-        buflen = r.d * r.n * 40
+        buflen = bgv_key_size(&self.k)
         cdef unsigned char* buf = <unsigned char*>malloc(buflen)
         if buf is NULL:
             raise MemoryError
@@ -204,16 +206,23 @@ cdef class BGVKey:
 
     def from_bytes(self, buf):
         cdef ring_t* r = <ring_t*>&self.b.r
-        buflen = r.d * r.n * 40
-        if len(buf) != buflen:
+        polylen = r.d * r.n * 8
+        # s | seed | pub.b | dnum | eval seed | b_0 ... b_{dnum-1}
+        off = 2 * polylen + POLY_SEED_BYTES
+        if len(buf) < off + 4 + POLY_SEED_BYTES:
+            raise ValueError("Invalid buffer size")
+        dnum = int.from_bytes(buf[off:off + 4], "little")
+        if len(buf) != (2 + dnum) * polylen + 4 + 2 * POLY_SEED_BYTES:
             raise ValueError("Invalid buffer size")
-        bgv_key_deserialize(r, &self.k, <unsigned char*>buf)
+        if bgv_key_deserialize(r, &self.k, <unsigned char*>buf):
+            raise MemoryError
 
     @staticmethod
     cdef BGVKey keygen(bgv_t *_ptr):
         # Fast call to __new__() that bypasses the __init__() constructor.
         cdef BGVKey key = BGVKey.__new__(BGVKey)
-        bgv_keygen(_ptr, &key.k)
+        if bgv_keygen(_ptr, &key.k):
+            raise MemoryError
         key.b = _ptr
         return key
 
@@ -227,7 +236,7 @@ cdef class BGVKey:
 
 cdef class CipherText:
     cdef bgv_ct_t *_ptr
-    cdef bgv_keypair_t *_evalptr
+    cdef bgv_ksk_t *_evalptr
     cdef bint ptr_owner
 
     def __cinit__(self):
@@ -278,7 +287,9 @@ cdef class CipherText:
         cdef bgv_ct_t *out = <bgv_ct_t *>malloc(sizeof(bgv_ct_t))
         if out is NULL:
             raise MemoryError
-        bgv_ct_mul(out, self._evalptr, self._ptr, o)
+        if bgv_ct_mul(out, self._evalptr, self._ptr, o):
+            free(out)
+            raise ValueError("Invalid ciphertext multiplication")
         return CipherText.from_ptr(out, self._evalptr, True)
 
     def __ptr__(self):
@@ -308,14 +319,19 @@ cdef class CipherText:
 
         d = self._ptr.c[0].r.d
         cdef cnp.uint64_t[:] a = np.zeros(d, dtype=np.uint64, order="C")
-        poly_decode(&a[0], out, modulus)
+        if poly_decode(&a[0], out, modulus):
+            free(out)
+            raise MemoryError
 
         free(out)
         return as_array(a)
 
+    @property
+    def level(self):
+        return bgv_ct_level(self._ptr)
+
     def bytes(self):
-        cdef ring_t* r = <ring_t*>self._ptr.c.r
-        buflen = r.d * r.n * 8 * self._ptr.n
+        buflen = bgv_ct_size(self._ptr)
         cdef unsigned char* buf = <unsigned char*>malloc(buflen)
         if buf is NULL:
             raise MemoryError
@@ -328,13 +344,18 @@ cdef class CipherText:
 
     def from_bytes(self, buf):
         cdef ring_t* r = <ring_t*>self._ptr.c.r
-        buflen = r.d * r.n * 8 * self._ptr.n
-        if len(buf) != buflen:
+        if len(buf) < 8:
             raise ValueError("Invalid buffer size")
-        bgv_ct_deserialize(r, self._ptr, <unsigned char*>buf)
+        n = int.from_bytes(buf[0:4], "little")
+        limbs = int.from_bytes(buf[4:8], "little")
+        buflen = r.d * limbs * 8 * n + 8
+        if n < 2 or n > 3 or limbs < 1 or limbs > r.n or len(buf) != buflen:
+            raise ValueError("Invalid buffer size")
+        if bgv_ct_deserialize(r, self._ptr, <unsigned char*>buf):
+            raise MemoryError
 
     @staticmethod
-    cdef CipherText from_ptr(bgv_ct_t *_ptr, bgv_keypair_t * ek, bint owner=False):
+    cdef CipherText from_ptr(bgv_ct_t *_ptr, bgv_ksk_t * ek, bint owner=False):
         # Fast call to __new__() that bypasses the __init__() constructor.
         cdef CipherText ct = CipherText.__new__(CipherText)
         ct._ptr = _ptr
@@ -345,8 +366,9 @@ cdef class CipherText:
 cdef class BGV:
     cdef bgv_t b
 
-    def __init__(self, lgd=14, lgq=237, lgm=25, t=65537):
-        bgv_init(&self.b, lgd, lgq, lgm, t)
+    def __init__(self, lgd=14, lgq=237, lgm=60, t=65537):
+        if bgv_init(&self.b, lgd, lgq, lgm, t):
+            raise ValueError("Invalid BGV parameters")
 
     @property
     def t(self):
@@ -365,6 +387,10 @@ cdef class BGV:
     def __del__(self):
         bgv_free(&self.b)
 
+    def modswitch(self, CipherText c):
+        if bgv_ct_modswitch(&self.b, c._ptr):
+            raise ValueError("Ciphertext is at level 0")
+
     def encode(self, cnp.ndarray[uint64_t, mode="c"] p not None):
         cdef poly_t *out =  <poly_t *>malloc(sizeof(poly_t))
         if out is NULL:
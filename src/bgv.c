@@ -25,112 +25,190 @@
 
 #include <errno.h>
 #include <stdlib.h>
+#include <string.h>
 
-void bgv_ksgen(const bgv_t *const b, bgv_key_t *k, const poly_t *const s) {
-  bgv_keypair_t *eval = &k->eval;
-  poly_t e;
+int bgv_init(bgv_t *b, size_t lgd, size_t lgq, size_t lgm, size_t t) {
+  return bgv_init_dnum(b, lgd, lgq, lgm, t, BGV_DNUM);
+}
 
-  poly_rand(&b->r, &e, ERR);
-  poly_cmul(&e, &e, b->t);
-  poly_ntt(&e);
+int bgv_init_dnum(bgv_t *b, size_t lgd, size_t lgq, size_t lgm, size_t t,
+                  size_t dnum) {
+  int err = ring_init_congruent(&b->r, lgd, lgq, lgm, t);
+  if (err)
+    return err;
+  b->t = t;
+  b->dnum = dnum < 1 ? 1 : dnum > b->r.n ? b->r.n : dnum;
+  return 0;
+}
 
-  poly_rand(&b->r, &eval->a, UNIFORM);
-  poly_ntt(&eval->a);
+int bgv_init_file(bgv_t *b, const char *path, size_t t, size_t dnum) {
+  int err;
 
-  poly_clone(&eval->b, &eval->a);
-  poly_mul(&eval->b, &eval->b, &k->s);
-  poly_sub(&eval->b, &e, &eval->b);
-  poly_add(&eval->b, &eval->b, s);
+  if (t < 2)
+    return -EINVAL;
+  if ((err = ring_load(&b->r, path)))
+    return err;
 
-  poly_free(&e);
-}
+  /* Same residues as ring_init_congruent(..., t) */
+  for (size_t i = 0; i < b->r.n; ++i)
+    if ((b->r.m[i] - 1) % t) {
+      ring_free(&b->r);
+      return -EINVAL;
+    }
 
-int bgv_init(bgv_t *b, size_t lgd, size_t lgq, size_t lgm, size_t t) {
   b->t = t;
-  return ring_init(&b->r, lgd, lgq, lgm);
+  b->dnum = dnum < 1 ? 1 : dnum > b->r.n ? b->r.n : dnum;
+  return 0;
 }
 
-void bgv_keygen(const bgv_t *const b, bgv_key_t *k) {
+int bgv_keygen(const bgv_t *const b, bgv_key_t *k) {
+  return bgv_keygen_rng(b, k, NULL);
+}
+
+int bgv_keygen_rng(const bgv_t *const b, bgv_key_t *k, poly_rng_t *g) {
   bgv_keypair_t *pub = &k->pub;
   poly_t e;
-
-  poly_rand(&b->r, &k->s, TERNARY);
-  poly_ntt(&k->s);
-
-  poly_rand(&b->r, &pub->a, UNIFORM);
-  poly_ntt(&pub->a);
-
-  poly_rand(&b->r, &e, ERR);
+  poly_t *batch[] = {&k->s, &e};
+  int err;
+
+  poly_rng_bytes(g, k->seed, POLY_SEED_BYTES);
+  if ((err = poly_expand(&b->r, &pub->a, k->seed, 0)))
+    return err;
+  poly_rand_rng(&b->r, &k->s, TERNARY, g);
+  poly_rand_rng(&b->r, &e, ERR_CDT, g);
   poly_cmul(&e, &e, b->t);
-  poly_ntt(&e);
+  poly_ntt_batch(batch, 2);
 
-  poly_clone(&pub->b, &pub->a);
-  poly_mul(&pub->b, &pub->b, &k->s);
-  poly_sub(&pub->b, &e, &pub->b);
+  if ((err = poly_zero(&b->r, &pub->b)))
+    goto FREE_S;
+  poly_mul_sub(&pub->b, &pub->a, &k->s, &e);
 
   poly_mul(&e, &k->s, &k->s);
-  bgv_ksgen(b, k, &e);
+  if ((err = bgv_ksk_gen_rng(b, &k->eval, &k->s, &e, g)))
+    goto FREE_B;
 
   poly_free(&e);
+  return 0;
+
+FREE_B:
+  poly_free(&pub->b);
+FREE_S:
+  poly_free(&e);
+  poly_free(&k->s);
+  poly_free(&pub->a);
+  return err;
 }
 
 void bgv_key_zero(const ring_t *const r, bgv_key_t *k) {
   poly_zero(r, &k->s);
   poly_zero(r, &k->pub.a);
   poly_zero(r, &k->pub.b);
-  poly_zero(r, &k->eval.a);
-  poly_zero(r, &k->eval.b);
+  k->eval = (bgv_ksk_t){0};
 }
 
 int bgv_key_cmp(const bgv_key_t *const a, const bgv_key_t *const b) {
-  int flag = poly_cmp(&a->s, &b->s);
-  flag |= poly_cmp(&a->pub.a, &b->pub.a);
-  flag |= poly_cmp(&a->pub.b, &b->pub.b);
-  flag |= poly_cmp(&a->eval.a, &b->eval.a);
-  flag |= poly_cmp(&a->eval.b, &b->eval.b);
+  /* Every component has to match, not just one of them */
+  int flag = a->eval.dnum == b->eval.dnum;
+  flag &= poly_cmp(&a->s, &b->s);
+  flag &= !memcmp(a->seed, b->seed, POLY_SEED_BYTES);
+  flag &= poly_cmp(&a->pub.a, &b->pub.a);
+  flag &= poly_cmp(&a->pub.b, &b->pub.b);
+  flag &= !memcmp(a->eval.seed, b->eval.seed, POLY_SEED_BYTES);
+  for (size_t j = 0; j < a->eval.dnum && flag; ++j) {
+    flag &= poly_cmp(&a->eval.k[j].a, &b->eval.k[j].a);
+    flag &= poly_cmp(&a->eval.k[j].b, &b->eval.k[j].b);
+  }
   return flag;
 }
 
 void bgv_encrypt(const bgv_t *const b, bgv_ct_t *c,
                  const bgv_keypair_t *const k, const poly_t *const m) {
-  poly_t u, e1, e2;
-
   bgv_ct_init(&b->r, c, 2);
+  bgv_encrypt_into(b, c, k, m);
+}
 
-  poly_rand(&b->r, &u, TERNARY);
-  poly_ntt(&u);
+int bgv_encrypt_into(const bgv_t *const b, bgv_ct_t *c,
+                     const bgv_keypair_t *const k, const poly_t *const m) {
+  return bgv_encrypt_into_rng(b, c, k, m, NULL);
+}
 
-  poly_rand(&b->r, &e1, ERR);
-  poly_cmul(&e1, &e1, b->t);
-  poly_ntt(&e1);
+int bgv_encrypt_into_rng(const bgv_t *const b, bgv_ct_t *c,
+                         const bgv_keypair_t *const k, const poly_t *const m,
+                         poly_rng_t *g) {
+  poly_t u, e1, e2;
+  poly_t *batch[] = {&u, &e1, &e2};
 
-  poly_rand(&b->r, &e2, ERR);
+  if (c->n != 2)
+    return -EINVAL;
+
+  poly_rand_rng(&b->r, &u, TERNARY, g);
+  poly_rand_rng(&b->r, &e1, ERR_CDT, g);
+  poly_cmul(&e1, &e1, b->t);
+  poly_rand_rng(&b->r, &e2, ERR_CDT, g);
   poly_cmul(&e2, &e2, b->t);
-  poly_ntt(&e2);
+  poly_ntt_batch(batch, 3);
 
-  poly_mul(c->c + 1, &u, &k->a);
-  poly_add(c->c + 1, c->c + 1, &e1);
+  poly_mul_add(c->c + 1, &u, &k->a, &e1);
 
-  poly_mul(c->c, &u, &k->b);
-  poly_add(c->c, c->c, &e2);
-  poly_add(c->c, c->c, m);
+  poly_add(&e2, &e2, m);
+  poly_mul_add(c->c, &u, &k->b, &e2);
 
   poly_free(&u);
   poly_free(&e1);
   poly_free(&e2);
+  return 0;
+}
+
+int bgv_encrypt_sym(const bgv_t *const b, bgv_ct_t *c, const poly_t *const s,
+                    const poly_t *const m, unsigned char *seed) {
+  return bgv_encrypt_sym_rng(b, c, s, m, seed, NULL);
+}
+
+int bgv_encrypt_sym_rng(const bgv_t *const b, bgv_ct_t *c,
+                        const poly_t *const s, const poly_t *const m,
+                        unsigned char *seed, poly_rng_t *g) {
+  poly_t a, e;
+  int err;
+
+  poly_rng_bytes(g, seed, POLY_SEED_BYTES);
+  if ((err = poly_expand(&b->r, &a, seed, 0)))
+    return err;
+  if ((err = bgv_ct_init(&b->r, c, 2))) {
+    poly_free(&a);
+    return err;
+  }
+  poly_free(c->c + 1);
+  c->c[1] = a;
+
+  poly_rand_rng(&b->r, &e, ERR_CDT, g);
+  poly_cmul(&e, &e, b->t);
+  poly_ntt(&e);
+  poly_add(&e, &e, m);
+  poly_mul_sub(c->c, c->c + 1, s, &e);
+
+  poly_free(&e);
+  return 0;
 }
 
 void bgv_decrypt(poly_t *m, const bgv_ct_t *const c, const poly_t *const s) {
   if (c->n > 0) {
-    poly_clone(m, c->c + c->n - 1);
-    for (size_t i = c->n - 1; i > 0; --i) {
-      poly_mul(m, m, s);
-      poly_add(m, m, c->c + i - 1);
-    }
-    poly_intt(m);
+    poly_zero(c->c->r, m);
+    bgv_decrypt_into(m, c, s);
   }
 }
 
+int bgv_decrypt_into(poly_t *m, const bgv_ct_t *const c,
+                     const poly_t *const s) {
+  if (!c->n)
+    return -EINVAL;
+
+  poly_copy(m, c->c + c->n - 1);
+  for (size_t i = c->n - 1; i > 0; --i)
+    poly_mul_add(m, m, s, c->c + i - 1);
+  poly_intt(m);
+  return 0;
+}
+
 void bgv_free(bgv_t *b) {
   b->t = 0;
   ring_free(&b->r);
@@ -140,8 +218,7 @@ void bgv_key_free(bgv_key_t *k) {
   poly_free(&k->s);
   poly_free(&k->pub.a);
   poly_free(&k->pub.b);
-  poly_free(&k->eval.a);
-  poly_free(&k->eval.b);
+  bgv_ksk_free(&k->eval);
 }
 
 int bgv_ct_init(const ring_t *const r, bgv_ct_t *c, size_t n) {
@@ -155,48 +232,178 @@ int bgv_ct_init(const ring_t *const r, bgv_ct_t *c, size_t n) {
 
 void bgv_ct_add(bgv_ct_t *out, const bgv_ct_t *const x,
                 const bgv_ct_t *const y) {
-  if (out && x->n == y->n) {
-    bgv_ct_init(x->c->r, out, x->n);
-    for (size_t i = 0; i < out->n; ++i)
-      poly_add(out->c + i, x->c + i, y->c + i);
+  if (out) {
+    bgv_ct_init(x->c->r, out, x->n > y->n ? x->n : y->n);
+    bgv_ct_add_into(out, x, y);
   }
 }
 
-void bgv_ct_mul(bgv_ct_t *c, const bgv_keypair_t *const ek,
-                const bgv_ct_t *const x, const bgv_ct_t *const y) {
-  if (x->n == 2 && y->n == 2) {
-    poly_t tmp;
-
-    bgv_ct_init(x->c->r, c, x->n + 1);
-    poly_zero(c->c->r, &tmp);
+int bgv_ct_add_into(bgv_ct_t *out, const bgv_ct_t *const x,
+                    const bgv_ct_t *const y) {
+  const bgv_ct_t *lo = x->n < y->n ? x : y, *hi = x->n < y->n ? y : x;
 
-    poly_mul(c->c, x->c, y->c);
-    poly_mul(c->c + 2, x->c + 1, y->c + 1);
+  if (out->n != hi->n)
+    return -EINVAL;
+  for (size_t i = 0; i < lo->n; ++i)
+    poly_add(out->c + i, x->c + i, y->c + i);
+  for (size_t i = lo->n; i < hi->n; ++i)
+    poly_copy(out->c + i, hi->c + i);
+  return 0;
+}
 
-    poly_mul(c->c + 1, x->c, y->c + 1);
-    poly_mul(&tmp, x->c + 1, y->c);
-    poly_add(c->c + 1, c->c + 1, &tmp);
+void bgv_ct_sub(bgv_ct_t *out, const bgv_ct_t *const x,
+                const bgv_ct_t *const y) {
+  if (out) {
+    bgv_ct_init(x->c->r, out, x->n > y->n ? x->n : y->n);
+    bgv_ct_sub_into(out, x, y);
+  }
+}
 
-    poly_free(&tmp);
+int bgv_ct_sub_into(bgv_ct_t *out, const bgv_ct_t *const x,
+                    const bgv_ct_t *const y) {
+  size_t n = x->n < y->n ? x->n : y->n;
 
-    bgv_ct_relin(c, ek);
+  if (out->n != (x->n > y->n ? x->n : y->n))
+    return -EINVAL;
+  for (size_t i = 0; i < n; ++i)
+    poly_sub(out->c + i, x->c + i, y->c + i);
+  for (size_t i = n; i < x->n; ++i)
+    poly_copy(out->c + i, x->c + i);
+  for (size_t i = n; i < y->n; ++i) {
+    poly_copy(out->c + i, y->c + i);
+    poly_neg(out->c + i);
   }
+  return 0;
+}
+
+void bgv_pt_encode(const bgv_t *const b, bgv_pt_t *pt, const uint_t *const x) {
+  poly_encode_mod(&b->r, x, b->t, &pt->p);
 }
 
-void bgv_ct_relin(bgv_ct_t *c, const bgv_keypair_t *const k) {
+void bgv_pt_free(bgv_pt_t *pt) { poly_free(&pt->p); }
+
+/* m in NTT form, transformed into tmp when given in coefficient form */
+static const poly_t *plain_ntt(const poly_t *const m, poly_t *tmp) {
+  *tmp = (poly_t){0};
+  if (m->is_ntt)
+    return m;
+  poly_clone(tmp, m);
+  poly_ntt(tmp);
+  return tmp;
+}
+
+int bgv_ct_add_plain(bgv_ct_t *out, const bgv_ct_t *const x,
+                     const poly_t *const m) {
+  poly_t tmp;
+
+  if (!x->n || out->n != x->n)
+    return -EINVAL;
+  poly_add(out->c, x->c, plain_ntt(m, &tmp));
+  for (size_t i = 1; i < x->n; ++i)
+    poly_copy(out->c + i, x->c + i);
+  poly_free(&tmp);
+  return 0;
+}
+
+int bgv_ct_mul_plain(bgv_ct_t *out, const bgv_ct_t *const x,
+                     const poly_t *const m) {
+  poly_t tmp;
+  const poly_t *w;
+
+  if (out->n != x->n)
+    return -EINVAL;
+  w = plain_ntt(m, &tmp);
+  for (size_t i = 0; i < x->n; ++i)
+    poly_mul(out->c + i, x->c + i, w);
+  poly_free(&tmp);
+  return 0;
+}
+
+int bgv_ct_mul_scalar(bgv_ct_t *out, const bgv_ct_t *const x, int_t s) {
+  if (out->n != x->n)
+    return -EINVAL;
+  for (size_t i = 0; i < x->n; ++i)
+    poly_cmul(out->c + i, x->c + i, s);
+  return 0;
+}
+
+int bgv_ct_mul(bgv_ct_t *c, const bgv_ksk_t *const ek,
+               const bgv_ct_t *const x, const bgv_ct_t *const y) {
+  int err;
+
+  if (x->n != 2 || y->n != 2)
+    return -EINVAL;
+  if ((err = bgv_ct_init(x->c->r, c, x->n + 1)))
+    return err;
+
+  poly_tensor(c->c, x->c, y->c);
+  if (ek && (err = bgv_ct_relin(c, ek)))
+    bgv_ct_free(c);
+  return err;
+}
+
+int bgv_ct_mul_into(bgv_ct_t *c, const bgv_ksk_t *const ek,
+                    const bgv_ct_t *const x, const bgv_ct_t *const y) {
+  poly_t t[3];
+  int err;
+
+  if (x->n != 2 || y->n != 2 || (c->n != 3 && (c->n != 2 || !ek)))
+    return -EINVAL;
+
   if (c->n == 3) {
-    poly_t tmp;
-    poly_clone(&tmp, c->c + 2);
-    poly_mul(&tmp, &tmp, &k->b);
-    poly_mul(c->c + 2, c->c + 2, &k->a);
+    poly_tensor(c->c, x->c, y->c);
+    return 0;
+  }
+
+  /* Only the quadratic term needs a temporary */
+  if ((err = poly_zero(c->c->r, t + 2)))
+    return err;
+  t[0] = c->c[0];
+  t[1] = c->c[1];
+  poly_tensor(t, x->c, y->c);
+  c->c[0] = t[0];
+  c->c[1] = t[1];
+
+  err = bgv_keyswitch(ek, c->c, c->c + 1, t + 2);
+  poly_free(t + 2);
+  return err;
+}
+
+size_t bgv_ct_level(const bgv_ct_t *const c) {
+  size_t n = c->n ? c->c->n : 0;
+  for (size_t i = 1; i < c->n; ++i)
+    n = c->c[i].n < n ? c->c[i].n : n;
+  return n ? n - 1 : 0;
+}
 
-    poly_add(c->c, c->c, &tmp);
-    poly_add(c->c + 1, c->c + 1, c->c + 2);
+int bgv_ct_modswitch(const bgv_t *const b, bgv_ct_t *c) {
+  const size_t n = bgv_ct_level(c) + 1;
+  int err;
 
-    c->n = 2;
-    poly_free(c->c + 2);
-    poly_free(&tmp);
+  if (!c->n || n < 2)
+    return -EINVAL;
+
+  /* Polynomials above the ciphertext level are truncated first */
+  for (size_t i = 0; i < c->n; ++i) {
+    c->c[i].n = n;
+    if ((err = poly_rescale(c->c + i, b->t)))
+      return err;
   }
+  return 0;
+}
+
+int bgv_ct_relin(bgv_ct_t *c, const bgv_ksk_t *const k) {
+  int err;
+
+  if (c->n != 3)
+    return c->n == 2 ? 0 : -EINVAL;
+  /* c2 is only dropped once its key switch went through */
+  if ((err = bgv_keyswitch(k, c->c, c->c + 1, c->c + 2)))
+    return err;
+
+  c->n = 2;
+  poly_free(c->c + 2);
+  return 0;
 }
 
 void bgv_key_serialize(unsigned char *buf, const bgv_key_t *const k) {
@@ -204,53 +411,172 @@ void bgv_key_serialize(unsigned char *buf, const bgv_key_t *const k) {
   size_t len = (r->d * r->n) << 3;
   poly_serialize(buf, &k->s);
   buf += len;
-  poly_serialize(buf, &k->pub.a);
-  buf += len;
+  memcpy(buf, k->seed, POLY_SEED_BYTES);
+  buf += POLY_SEED_BYTES;
   poly_serialize(buf, &k->pub.b);
   buf += len;
-  poly_serialize(buf, &k->eval.a);
-  buf += len;
-  poly_serialize(buf, &k->eval.b);
-  buf += len;
+  U32_TO_BYTES(k->eval.dnum, buf);
+  buf += 4;
+  memcpy(buf, k->eval.seed, POLY_SEED_BYTES);
+  buf += POLY_SEED_BYTES;
+  for (size_t j = 0; j < k->eval.dnum; ++j) {
+    poly_serialize(buf, &k->eval.k[j].b);
+    buf += len;
+  }
 }
 
-void bgv_key_deserialize(const ring_t *const r, bgv_key_t *k,
-                         const unsigned char *buf) {
-  size_t len = (r->d * r->n) << 3;
-  poly_zero(r, &k->s);
+size_t bgv_key_size(const bgv_key_t *const k) {
+  ring_t *r = k->pub.a.r;
+  return (((r->d * r->n) << 3) * (2 + k->eval.dnum)) + 4 +
+         2 * POLY_SEED_BYTES;
+}
+
+int bgv_key_deserialize(const ring_t *const r, bgv_key_t *k,
+                        const unsigned char *buf) {
+  size_t dnum, len = (r->d * r->n) << 3;
+  int err;
+
+  if ((err = poly_zero(r, &k->s)))
+    return err;
   poly_deserialize(&k->s, buf);
+  k->s.is_ntt = 1;
   buf += len;
-  poly_zero(r, &k->pub.a);
-  poly_deserialize(&k->pub.a, buf);
-  buf += len;
-  poly_zero(r, &k->pub.b);
+  memcpy(k->seed, buf, POLY_SEED_BYTES);
+  buf += POLY_SEED_BYTES;
+  if ((err = poly_expand(r, &k->pub.a, k->seed, 0)))
+    goto FREE_S;
+  if ((err = poly_zero(r, &k->pub.b)))
+    goto FREE_A;
   poly_deserialize(&k->pub.b, buf);
+  k->pub.b.is_ntt = 1;
   buf += len;
-  poly_zero(r, &k->eval.a);
-  poly_deserialize(&k->eval.a, buf);
-  buf += len;
-  poly_zero(r, &k->eval.b);
-  poly_deserialize(&k->eval.b, buf);
-  buf += len;
+  U32_FROM_BYTES(dnum, buf);
+  buf += 4;
+  if ((err = bgv_ksk_init(r, &k->eval, dnum)))
+    goto FREE_B;
+  memcpy(k->eval.seed, buf, POLY_SEED_BYTES);
+  buf += POLY_SEED_BYTES;
+  for (size_t j = 0; j < k->eval.dnum; ++j) {
+    if ((err = poly_expand(r, &k->eval.k[j].a, k->eval.seed, j)) ||
+        (err = poly_zero(r, &k->eval.k[j].b)))
+      goto FREE_EVAL;
+    poly_deserialize(&k->eval.k[j].b, buf);
+    k->eval.k[j].b.is_ntt = 1;
+    buf += len;
+  }
+  return 0;
+
+FREE_EVAL:
+  bgv_ksk_free(&k->eval);
+FREE_B:
+  poly_free(&k->pub.b);
+FREE_A:
+  poly_free(&k->pub.a);
+FREE_S:
+  poly_free(&k->s);
+  return err;
+}
+
+size_t bgv_ct_size(const bgv_ct_t *const c) {
+  ring_t *r = c->c->r;
+  return (((r->d * (bgv_ct_level(c) + 1)) << 3) * c->n) + 8;
 }
 
 void bgv_ct_serialize(unsigned char *buf, const bgv_ct_t *const c) {
   ring_t *r = c->c->r;
-  size_t len = (r->d * r->n) << 3;
+  size_t limbs = bgv_ct_level(c) + 1, len = (r->d * limbs) << 3;
   U32_TO_BYTES(c->n, buf);
   buf += 4;
-  for (size_t i = 0; i < c->n; ++i, buf += len)
-    poly_serialize(buf, c->c + i);
+  U32_TO_BYTES(limbs, buf);
+  buf += 4;
+  for (size_t i = 0; i < c->n; ++i, buf += len) {
+    poly_t p = c->c[i];
+    p.n = limbs;
+    poly_serialize(buf, &p);
+  }
 }
 
-void bgv_ct_deserialize(const ring_t *const r, bgv_ct_t *c,
-                        const unsigned char *buf) {
-  size_t n, len = (r->d * r->n) << 3;
+int bgv_ct_deserialize(const ring_t *const r, bgv_ct_t *c,
+                       const unsigned char *buf) {
+  size_t n, limbs, len;
+  int err;
+
   U32_FROM_BYTES(n, buf);
   buf += 4;
-  bgv_ct_init(r, c, n);
-  for (size_t i = 0; i < n; ++i, buf += len)
+  U32_FROM_BYTES(limbs, buf);
+  buf += 4;
+  /* Two polynomials, or three before relinearization; seeded streams have
+   * BGV_CT_SEEDED set in n */
+  if (n < 2 || n > 3 || !limbs || limbs > r->n)
+    return -EINVAL;
+  len = (r->d * limbs) << 3;
+  if ((err = bgv_ct_init(r, c, n)))
+    return err;
+  for (size_t i = 0; i < n; ++i, buf += len) {
+    c->c[i].n = limbs;
     poly_deserialize(c->c + i, buf);
+    c->c[i].is_ntt = 1;
+  }
+  return 0;
+}
+
+size_t bgv_ct_seeded_size(const bgv_ct_t *const c) {
+  return 8 + ((c->c->r->d * c->c->r->n) << 3) + POLY_SEED_BYTES;
+}
+
+int bgv_ct_serialize_seeded(unsigned char *buf, const bgv_ct_t *const c,
+                            const unsigned char *const seed) {
+  ring_t *r = c->c->r;
+  poly_t a;
+  int err, same;
+
+  if (c->n != 2 || bgv_ct_level(c) != r->n - 1)
+    return -EINVAL;
+
+  /* Operations such as bgv_ct_mul_scalar rewrite c1, which the receiver
+   * could then no longer expand from the seed */
+  if ((err = poly_expand(r, &a, seed, 0)))
+    return err;
+  same = poly_cmp(&a, c->c + 1);
+  poly_free(&a);
+  if (!same)
+    return -EINVAL;
+
+  U32_TO_BYTES((c->n | BGV_CT_SEEDED), buf);
+  buf += 4;
+  U32_TO_BYTES(r->n, buf);
+  buf += 4;
+  poly_serialize(buf, c->c);
+  buf += (r->d * r->n) << 3;
+  for (size_t i = 0; i < POLY_SEED_BYTES; ++i)
+    buf[i] = seed[i];
+  return 0;
+}
+
+int bgv_ct_deserialize_seeded(const ring_t *const r, bgv_ct_t *c,
+                              const unsigned char *buf) {
+  size_t n, limbs;
+  poly_t a;
+  int err;
+
+  U32_FROM_BYTES(n, buf);
+  buf += 4;
+  U32_FROM_BYTES(limbs, buf);
+  buf += 4;
+  /* Only fresh ciphertexts at the top level are stored seeded */
+  if (n != (2 | BGV_CT_SEEDED) || limbs != r->n)
+    return -EINVAL;
+  if ((err = poly_expand(r, &a, buf + ((r->d * r->n) << 3), 0)))
+    return err;
+  if ((err = bgv_ct_init(r, c, 2))) {
+    poly_free(&a);
+    return err;
+  }
+  poly_deserialize(c->c, buf);
+  c->c->is_ntt = 1;
+  poly_free(c->c + 1);
+  c->c[1] = a;
+  return 0;
 }
 
 void bgv_ct_free(bgv_ct_t *c) {
@@ -0,0 +1,136 @@
+// libfhe
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// This file implements the BGV slot (batching) encoder.
+///
+/// For a prime \f$t \equiv 1 \bmod 2d\f$ the negacyclic NTT mod t maps a
+/// plaintext to its values at the odd powers \f$\psi^{2 brv(j) + 1}\f$ of
+/// a primitive 2d-th root, which is an isomorphism of rings. Slot i of
+/// row 0 holds the value at \f$\psi^{3^i}\f$ and slot i of row 1 the value
+/// at \f$\psi^{-3^i}\f$, so that \f$\sigma_{3^k}\f$ rotates both rows.
+///
+//===----------------------------------------------------------------------===//
+
+#include <errno.h>
+#include <stdlib.h>
+
+#include "fhe_bgv.h"
+
+#include "ntt.h"
+#include "utils/const_time.h"
+#include "utils/number_theory.h"
+
+int bgv_batch_init(const bgv_t *const b, bgv_batch_t *e) {
+  const size_t lgd = b->r.lgd, d = b->r.d, mask = (d << 1) - 1;
+  const uint_t t = b->t;
+  uint_t root, iroot;
+
+  *e = (bgv_batch_t){0};
+  if (!lgd || t < 3 || (t - 1) & mask || !is_prime(t))
+    return -EINVAL;
+
+  if (!(e->roots = malloc(sizeof(uint_t) * d * 4)))
+    goto FREE_ROOTS;
+  if (!(e->slot = malloc(sizeof(size_t) * d)))
+    goto FREE_SLOT;
+  e->roots_shoup = e->roots + d;
+  e->iroots = e->roots + 2 * d;
+  e->iroots_shoup = e->roots + 3 * d;
+
+  e->t = t;
+  e->lgd = lgd;
+  e->dinv = modinv(d, t);
+  e->dinv_shoup = shoup(e->dinv, t);
+
+  /* Same bit reversed layout as the ring tables, see ring_init */
+  root = find_proot(t, lgd + 1);
+  iroot = modinv(root, t);
+  for (size_t j = 0, power = 1, ipower = 1; j < d; ++j) {
+    size_t index = const_time_reverse32(j) >> (32 - lgd);
+    e->roots[index] = power;
+    e->roots_shoup[index] = shoup(power, t);
+    e->iroots[index] = ipower;
+    e->iroots_shoup[index] = shoup(ipower, t);
+    power = modmul(power, root, t);
+    ipower = modmul(ipower, iroot, t);
+  }
+
+  /* Transform index j evaluates at psi^(2 brv(j) + 1) */
+  for (size_t i = 0, g = 1; i < (d >> 1); ++i, g = g * 3 & mask) {
+    const size_t h = (mask - g) >> 1; /* (-g - 1) / 2 mod d */
+    e->slot[i] = const_time_reverse32(g >> 1) >> (32 - lgd);
+    e->slot[i + (d >> 1)] = const_time_reverse32(h) >> (32 - lgd);
+  }
+
+  return 0;
+
+FREE_SLOT:
+  free(e->roots);
+FREE_ROOTS:
+  *e = (bgv_batch_t){0};
+  return -errno;
+}
+
+int bgv_batch_encode(const bgv_t *const b, const bgv_batch_t *const e,
+                     bgv_pt_t *pt, const uint_t *const x) {
+  const size_t d = (size_t)1 << e->lgd;
+  uint_t *y;
+
+  if (b->t != e->t || b->r.lgd != e->lgd)
+    return -EINVAL;
+  if (!(y = malloc(sizeof(uint_t) * d)))
+    return -errno;
+
+  for (size_t i = 0; i < d; ++i)
+    y[e->slot[i]] = x[i] % e->t;
+  _intt(ntt_impl(), e->iroots, e->iroots_shoup, y, d, e->t, e->dinv,
+        e->dinv_shoup);
+  bgv_pt_encode(b, pt, y);
+
+  free(y);
+  return 0;
+}
+
+int bgv_batch_decode(const bgv_batch_t *const e, uint_t *out,
+                     const poly_t *const m) {
+  const size_t d = (size_t)1 << e->lgd;
+  uint_t *y;
+  int err;
+
+  if (m->r->lgd != e->lgd || m->is_ntt)
+    return -EINVAL;
+  if (!(y = malloc(sizeof(uint_t) * d)))
+    return -errno;
+
+  if ((err = poly_decode(y, m, e->t))) {
+    free(y);
+    return err;
+  }
+  _ntt(ntt_impl(), e->roots, e->roots_shoup, y, d, e->t);
+  for (size_t i = 0; i < d; ++i)
+    out[i] = y[e->slot[i]];
+
+  free(y);
+  return 0;
+}
+
+void bgv_batch_free(bgv_batch_t *e) {
+  free(e->roots);
+  free(e->slot);
+  *e = (bgv_batch_t){0};
+}
@@ -0,0 +1,200 @@
+// libfhe
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// This file implements pools of precomputed BGV encryptions of zero.
+///
+/// A public key encryption of m is \f$(u b + e_2 + m, u a + e_1)\f$, so an
+/// encryption of zero turns into an encryption of m with a single addition
+/// in NTT form. The worker thread sleeps while the pool is full and is
+/// woken by every encryption taken from it.
+///
+//===----------------------------------------------------------------------===//
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+
+#include "fhe_bgv.h"
+
+struct encpool_t {
+  pthread_mutex_t lock;   ///< Guards every field below
+  pthread_cond_t cond;    ///< Signaled when the pool has room or stops
+  pthread_t worker;       ///< Background thread, if any
+  int background;         ///< Whether the worker is running
+  int stop;               ///< Asks the worker to exit
+  const bgv_t *b;         ///< BGV context
+  const bgv_keypair_t *k; ///< Public key
+  poly_t zero;            ///< Zero message
+  size_t cap;             ///< Maximum number of cached encryptions
+  size_t len;             ///< Number of cached encryptions
+  bgv_ct_t *cache;        ///< Cached encryptions
+};
+
+/* Fresh encryption of zero, outside of the lock */
+static int encpool_gen(const struct encpool_t *s, bgv_ct_t *c) {
+  int err;
+
+  if ((err = bgv_ct_init(&s->b->r, c, 2)))
+    return err;
+  return bgv_encrypt_into(s->b, c, s->k, &s->zero);
+}
+
+/* Cache c if there is room, the lock must be held */
+static void encpool_push(struct encpool_t *s, bgv_ct_t *c) {
+  if (s->len < s->cap)
+    s->cache[s->len++] = *c;
+  else
+    bgv_ct_free(c);
+}
+
+static void *encpool_worker(void *arg) {
+  struct encpool_t *s = arg;
+  bgv_ct_t c;
+
+  pthread_mutex_lock(&s->lock);
+  while (!s->stop) {
+    if (s->len == s->cap) {
+      pthread_cond_wait(&s->cond, &s->lock);
+      continue;
+    }
+    pthread_mutex_unlock(&s->lock);
+    if (encpool_gen(s, &c)) {
+      pthread_mutex_lock(&s->lock);
+      break;
+    }
+    pthread_mutex_lock(&s->lock);
+    encpool_push(s, &c);
+  }
+  pthread_mutex_unlock(&s->lock);
+  return NULL;
+}
+
+int bgv_encpool_init(const bgv_t *const b, bgv_encpool_t *p,
+                     const bgv_keypair_t *const k, size_t cap, int background) {
+  struct encpool_t *s;
+  int err = 0;
+
+  if (!(s = calloc(1, sizeof(struct encpool_t))))
+    goto FREE_S;
+  if (!(s->cache = calloc(cap ? cap : 1, sizeof(bgv_ct_t))))
+    goto FREE_CACHE;
+  if ((err = poly_zero(&b->r, &s->zero)))
+    goto FREE_ZERO;
+
+  s->b = b;
+  s->k = k;
+  s->cap = cap;
+  pthread_mutex_init(&s->lock, NULL);
+  pthread_cond_init(&s->cond, NULL);
+
+  if (background) {
+    if ((err = -pthread_create(&s->worker, NULL, encpool_worker, s))) {
+      pthread_cond_destroy(&s->cond);
+      pthread_mutex_destroy(&s->lock);
+      poly_free(&s->zero);
+      goto FREE_ZERO;
+    }
+    s->background = 1;
+  }
+
+  p->state = s;
+  return 0;
+
+FREE_ZERO:
+  free(s->cache);
+FREE_CACHE:
+  free(s);
+FREE_S:
+  p->state = NULL;
+  return err ? err : -errno;
+}
+
+int bgv_encpool_fill(bgv_encpool_t *p, size_t n) {
+  struct encpool_t *s = p->state;
+  bgv_ct_t c;
+  int err;
+
+  for (size_t i = 0; i < n; ++i) {
+    pthread_mutex_lock(&s->lock);
+    if (s->len == s->cap) {
+      pthread_mutex_unlock(&s->lock);
+      break;
+    }
+    pthread_mutex_unlock(&s->lock);
+
+    if ((err = encpool_gen(s, &c)))
+      return err;
+    pthread_mutex_lock(&s->lock);
+    encpool_push(s, &c);
+    pthread_mutex_unlock(&s->lock);
+  }
+
+  return 0;
+}
+
+size_t bgv_encpool_size(bgv_encpool_t *p) {
+  struct encpool_t *s = p->state;
+  size_t len;
+
+  pthread_mutex_lock(&s->lock);
+  len = s->len;
+  pthread_mutex_unlock(&s->lock);
+  return len;
+}
+
+int bgv_encrypt_pooled(bgv_encpool_t *p, bgv_ct_t *c, const poly_t *const m) {
+  struct encpool_t *s = p->state;
+  int err = 0, hit;
+
+  pthread_mutex_lock(&s->lock);
+  if ((hit = s->len > 0)) {
+    *c = s->cache[--s->len];
+    pthread_cond_signal(&s->cond);
+  }
+  pthread_mutex_unlock(&s->lock);
+
+  if (!hit && (err = encpool_gen(s, c)))
+    return err;
+
+  poly_add(c->c, c->c, m);
+  return 0;
+}
+
+void bgv_encpool_free(bgv_encpool_t *p) {
+  struct encpool_t *s = p->state;
+
+  if (!s)
+    return;
+
+  if (s->background) {
+    pthread_mutex_lock(&s->lock);
+    s->stop = 1;
+    pthread_cond_signal(&s->cond);
+    pthread_mutex_unlock(&s->lock);
+    pthread_join(s->worker, NULL);
+  }
+
+  while (s->len)
+    bgv_ct_free(s->cache + --s->len);
+  pthread_cond_destroy(&s->cond);
+  pthread_mutex_destroy(&s->lock);
+  poly_free(&s->zero);
+  free(s->cache);
+  free(s);
+  p->state = NULL;
+}
@@ -0,0 +1,195 @@
+// libfhe
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// This file implements Galois automorphisms of BGV ciphertexts.
+///
+/// Applying \f$\sigma_g : x \mapsto x^g\f$ to both polynomials of a
+/// ciphertext gives an encryption of \f$\sigma_g(m)\f$ under
+/// \f$\sigma_g(s)\f$, which is switched back to \f$s\f$ with a Galois key.
+/// The automorphism permutes the coefficients of the gadget digits of
+/// \f$c_1\f$ and preserves their norm, so the digits of \f$\sigma_g(c_1)\f$
+/// are the permuted digits of \f$c_1\f$. Hoisted rotations decompose
+/// \f$c_1\f$ once and only permute the digits for each step.
+///
+//===----------------------------------------------------------------------===//
+
+#include <errno.h>
+#include <stdlib.h>
+
+#include "fhe_bgv.h"
+
+#include "bgv_ksk.h"
+
+size_t bgv_galois_elt(const ring_t *const r, long step) {
+  const size_t mask = (r->d << 1) - 1;
+  /* 3 generates a cyclic subgroup of order d / 2 of the units mod 2d */
+  const long ord = r->d > 2 ? (long)(r->d >> 1) : 1;
+  size_t g = 1, e = ((step % ord) + ord) % ord;
+
+  while (e--)
+    g = g * 3 & mask;
+  return g;
+}
+
+int bgv_galois_keygen(const bgv_t *const b, bgv_galois_t *gk,
+                      const bgv_key_t *const k, const size_t *const g,
+                      size_t n) {
+  const size_t mask = (b->r.d << 1) - 1;
+  poly_t s;
+  int err;
+
+  gk->n = 0;
+  for (size_t i = 0; i < n; ++i)
+    if (!(g[i] & 1))
+      return -EINVAL;
+
+  if (!(gk->g = malloc(sizeof(size_t) * n)))
+    goto FREE_G;
+  if (!(gk->k = calloc(n, sizeof(bgv_ksk_t))))
+    goto FREE_K;
+  if (poly_zero(&b->r, &s))
+    goto FREE_S;
+
+  for (; gk->n < n; ++gk->n) {
+    gk->g[gk->n] = g[gk->n] & mask;
+    poly_automorph(&s, &k->s, gk->g[gk->n]);
+    if ((err = bgv_ksk_gen(b, gk->k + gk->n, &k->s, &s))) {
+      poly_free(&s);
+      bgv_galois_free(gk);
+      return err;
+    }
+  }
+
+  poly_free(&s);
+  return 0;
+
+FREE_S:
+  free(gk->k);
+FREE_K:
+  free(gk->g);
+FREE_G:
+  gk->g = NULL;
+  gk->k = NULL;
+  return -errno;
+}
+
+static const bgv_ksk_t *galois_find(const bgv_galois_t *const gk, size_t g) {
+  for (size_t i = 0; i < gk->n; ++i)
+    if (gk->g[i] == g)
+      return gk->k + i;
+  return NULL;
+}
+
+/* out[i] = sigma_g[i](c), all sharing the digits of c1 */
+static int galois_apply(const bgv_galois_t *const gk, bgv_ct_t *out,
+                        const bgv_ct_t *const c, const size_t *const g,
+                        size_t n) {
+  const ring_t *r = c->c->r;
+  const size_t mask = (r->d << 1) - 1;
+  size_t nd, i = 0;
+  poly_t *d, *t;
+  int err;
+
+  if (c->n != 2 || !gk->n)
+    return -EINVAL;
+  for (size_t l = 0; l < n; ++l)
+    if (!galois_find(gk, g[l] & mask))
+      return -EINVAL;
+
+  nd = ksk_ndigits(gk->k, c->c[1].n);
+  if (!(d = malloc(sizeof(poly_t) * nd * 2)))
+    return -errno;
+  t = d + nd;
+
+  if ((err = ksk_digits(gk->k, d, c->c + 1)))
+    goto FREE_D;
+  for (size_t j = 0; j < nd; ++j)
+    t[j] = (poly_t){0};
+  for (size_t j = 0; j < nd && !err; ++j)
+    err = poly_zero(r, t + j);
+
+  for (; i < n && !err; ++i) {
+    const size_t gi = g[i] & mask;
+
+    if ((err = bgv_ct_init(r, out + i, 2)))
+      break;
+    poly_automorph(out[i].c, c->c, gi);
+    for (size_t j = 0; j < nd; ++j)
+      poly_automorph(t + j, d + j, gi);
+    ksk_apply(galois_find(gk, gi), out[i].c, out[i].c + 1, t, 0, nd);
+  }
+
+  /* On failure the outputs produced so far are released */
+  if (err)
+    while (i--)
+      bgv_ct_free(out + i);
+
+  for (size_t j = 0; j < nd; ++j) {
+    poly_free(t + j);
+    poly_free(d + j);
+  }
+FREE_D:
+  free(d);
+  return err;
+}
+
+int bgv_ct_automorph(const bgv_galois_t *const gk, bgv_ct_t *c, size_t g) {
+  bgv_ct_t t;
+  int err;
+
+  if ((err = galois_apply(gk, &t, c, &g, 1)))
+    return err;
+  bgv_ct_free(c);
+  *c = t;
+  return 0;
+}
+
+int bgv_ct_rotate(const bgv_galois_t *const gk, bgv_ct_t *c, long step) {
+  if (!c->n)
+    return -EINVAL;
+  return bgv_ct_automorph(gk, c, bgv_galois_elt(c->c->r, step));
+}
+
+int bgv_ct_rotate_hoisted(const bgv_galois_t *const gk, bgv_ct_t *out,
+                          const bgv_ct_t *const c, const long *const steps,
+                          size_t n) {
+  size_t *g;
+  int err;
+
+  if (!c->n)
+    return -EINVAL;
+  if (!(g = malloc(sizeof(size_t) * n)))
+    return -errno;
+
+  for (size_t i = 0; i < n; ++i)
+    g[i] = bgv_galois_elt(c->c->r, steps[i]);
+  err = galois_apply(gk, out, c, g, n);
+
+  free(g);
+  return err;
+}
+
+void bgv_galois_free(bgv_galois_t *gk) {
+  for (size_t i = 0; i < gk->n; ++i)
+    bgv_ksk_free(gk->k + i);
+  free(gk->k);
+  free(gk->g);
+  gk->k = NULL;
+  gk->g = NULL;
+  gk->n = 0;
+}
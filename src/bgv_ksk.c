@@ -0,0 +1,326 @@
+// libfhe
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// This file implements RNS gadget key switching for the BGV scheme.
+///
+/// A polynomial x mod q is split into dnum digits
+/// \f$D_j = [x (q / Q_j)^{-1}]_{Q_j}\f$ with \f$x = \sum_j D_j (q / Q_j)\f$.
+/// Digits are lifted from their own limbs to all of q by fast base
+/// conversion. The lift may be off by a small multiple of \f$Q_j\f$, which
+/// vanishes once multiplied by \f$q / Q_j\f$.
+///
+/// Below the top level only the limbs of \f$q' | q\f$ are active. Digits
+/// keep their limbs in \f$q'\f$, \f$Q'_j = Q_j \cap q'\f$, and the key
+/// factor \f$q / Q_j = (q' / Q'_j) R_j\f$ mod \f$q'\f$ where \f$R_j\f$
+/// is the product of the dropped limbs outside digit j. The digits are then
+/// \f$D_j = [x (q' / Q'_j)^{-1} R_j^{-1}]_{Q'_j}\f$, so the same key serves
+/// every level.
+///
+//===----------------------------------------------------------------------===//
+
+#include <errno.h>
+#include <stdlib.h>
+
+#include "fhe_bgv.h"
+
+#include "bgv_ksk.h"
+#include "ntt.h"
+#include "utils/const_time.h"
+#include "utils/number_theory.h"
+
+/*
+ * Constants of the n active limbs: scale[i] turns x_i into the digit
+ * residue z_i, conv[i n + l] = [Q'_j / m_i]_{m_l} for limb i in digit j
+ */
+static void ksk_tables(const bgv_ksk_t *const k, const ring_t *const r,
+                       size_t n, uint_t *scale, uint_t *conv) {
+  for (size_t i = 0; i < n; ++i) {
+    const size_t lo = i / k->alpha * k->alpha;
+    const size_t hi = lo + k->alpha < n ? lo + k->alpha : n;
+    uint_t v = 1;
+
+    /* (q' / m_i) R_j */
+    for (size_t l = 0; l < r->n; ++l)
+      if (l != i && (l < n || l / k->alpha != i / k->alpha))
+        v = modmul(v, r->m[l], r->m[i]);
+    scale[i] = modinv(v, r->m[i]);
+
+    for (size_t l = 0; l < n; ++l) {
+      v = 1;
+      for (size_t g = lo; g < hi; ++g)
+        if (g != i)
+          v = modmul(v, r->m[g], r->m[l]);
+      conv[i * n + l] = v;
+    }
+  }
+}
+
+int bgv_ksk_init(const ring_t *const r, bgv_ksk_t *k, size_t dnum) {
+  dnum = dnum < 1 ? 1 : dnum > r->n ? r->n : dnum;
+  k->alpha = (r->n + dnum - 1) / dnum;
+  k->dnum = (r->n + k->alpha - 1) / k->alpha;
+
+  if (!(k->k = calloc(k->dnum, sizeof(bgv_keypair_t))))
+    goto FREE_K;
+  if (!(k->tab = malloc(sizeof(uint_t) * KSK_TAB_OFFSET(r->n + 1))))
+    goto FREE_TAB;
+
+  for (size_t n = 1; n <= r->n; ++n)
+    ksk_tables(k, r, n, k->tab + KSK_TAB_OFFSET(n),
+               k->tab + KSK_TAB_OFFSET(n) + n);
+  return 0;
+
+FREE_TAB:
+  free(k->k);
+  k->k = NULL;
+FREE_K:
+  k->dnum = 0;
+  return -errno;
+}
+
+int bgv_ksk_gen(const bgv_t *const b, bgv_ksk_t *k, const poly_t *const s,
+                const poly_t *const from) {
+  return bgv_ksk_gen_rng(b, k, s, from, NULL);
+}
+
+int bgv_ksk_gen_rng(const bgv_t *const b, bgv_ksk_t *k, const poly_t *const s,
+                    const poly_t *const from, poly_rng_t *g) {
+  const ring_t *r = &b->r;
+  uint_t *qhat;
+  int err;
+
+  if ((err = bgv_ksk_init(r, k, b->dnum)))
+    return err;
+
+  if (!(qhat = malloc(sizeof(uint_t) * r->n))) {
+    bgv_ksk_free(k);
+    return -errno;
+  }
+
+  poly_rng_bytes(g, k->seed, POLY_SEED_BYTES);
+  for (size_t j = 0; j < k->dnum && !err; ++j) {
+    bgv_keypair_t *p = k->k + j;
+    poly_t e;
+
+    /* q / Q_j in every limb, zero on the limbs of digit j */
+    for (size_t i = 0; i < r->n; ++i) {
+      qhat[i] = 1;
+      for (size_t l = 0; l < r->n; ++l)
+        if (l / k->alpha != j)
+          qhat[i] = modmul(qhat[i], r->m[l], r->m[i]);
+    }
+
+    if ((err = poly_expand(r, &p->a, k->seed, j)))
+      break;
+    poly_rand_rng(r, &e, ERR_CDT, g);
+    poly_cmul(&e, &e, b->t);
+    poly_ntt(&e);
+
+    if (!(err = poly_zero(r, &p->b))) {
+      poly_cmul_rns(&p->b, from, qhat);
+      poly_add(&p->b, &p->b, &e);
+      poly_mul_sub(&p->b, &p->a, s, &p->b);
+    }
+
+    poly_free(&e);
+  }
+
+  free(qhat);
+  if (err)
+    bgv_ksk_free(k);
+  return err;
+}
+
+/* Tables of level n, scale then conv, see ksk_tables */
+static inline const uint_t *ksk_tab(const bgv_ksk_t *const k, size_t n) {
+  return k->tab + KSK_TAB_OFFSET(n);
+}
+
+/* z = [x (q' / m_i)^-1 R_j^-1]_{m_i} in coefficient form */
+static int ksk_scale(const bgv_ksk_t *const k, poly_t *z,
+                     const poly_t *const x) {
+  int err;
+
+  if ((err = poly_zero(x->r, z)))
+    return err;
+  poly_copy(z, x);
+  poly_intt(z);
+  poly_cmul_rns(z, z, ksk_tab(k, x->n));
+  return 0;
+}
+
+/* Lift digits j0, ..., j0 + nd - 1 of z to all limbs, into d[0, nd) */
+static void ksk_decompose(const bgv_ksk_t *const k, poly_t *d,
+                          const poly_t *const z, size_t j0, size_t nd) {
+  const ring_t *r = z->r;
+  const size_t n = z->n;
+  const uint_t *conv = ksk_tab(k, n) + n;
+
+  OMP_FOR
+  for (size_t l = 0; l < n; ++l) {
+    const uint_t q = r->m[l], r64 = (-q) % q, r64p = shoup(r64, q);
+    const uint_t one = shoup(1, q);
+    const unsigned room = 128 - (bitlen(q) << 1);
+    const size_t chunk = room >= 64 ? SIZE_MAX : ((size_t)1 << room) - 1;
+
+    for (size_t j = j0; j < j0 + nd; ++j) {
+      const size_t lo = j * k->alpha;
+      const size_t hi = lo + k->alpha < n ? lo + k->alpha : n;
+      uint_t *y = d[j - j0].b + (l << r->lgd);
+
+      for (size_t x = 0; x < r->d; ++x) {
+        uint_dt acc = 0;
+        for (size_t i = lo, c = 0; i < hi; ++i) {
+          if (++c > chunk) {
+            acc = modred_wide(acc, q, r64, r64p, one);
+            c = 1;
+          }
+          acc += (uint_dt)z->b[(i << r->lgd) + x] * conv[i * n + l];
+        }
+        y[x] = modred_wide(acc, q, r64, r64p, one);
+      }
+    }
+  }
+
+  for (size_t j = 0; j < nd; ++j) {
+    d[j].n = n;
+    d[j].is_ntt = 0;
+  }
+}
+
+/* Forward transform of nd digits, every limb of every digit in parallel */
+static void ksk_ntt(poly_t *d, size_t nd) {
+  const ring_t *r = d->r;
+  const size_t n = d->n;
+
+  ntt_impl();
+  OMP_FOR
+  for (size_t c = 0; c < nd * n; ++c)
+    ntt_limb(r, d[c / n].b + ((c % n) << r->lgd), c % n);
+
+  for (size_t j = 0; j < nd; ++j)
+    d[j].is_ntt = 1;
+}
+
+int ksk_digits(const bgv_ksk_t *const k, poly_t *d, const poly_t *const x) {
+  const ring_t *r = x->r;
+  const size_t n = ksk_ndigits(k, x->n);
+  poly_t z;
+  int err;
+
+  for (size_t j = 0; j < n; ++j)
+    if ((err = poly_zero(r, d + j))) {
+      while (j--)
+        poly_free(d + j);
+      return err;
+    }
+
+  if ((err = ksk_scale(k, &z, x))) {
+    for (size_t j = 0; j < n; ++j)
+      poly_free(d + j);
+    return err;
+  }
+  ksk_decompose(k, d, &z, 0, n);
+  ksk_ntt(d, n);
+  poly_free(&z);
+  return 0;
+}
+
+void ksk_apply(const bgv_ksk_t *const k, poly_t *c0, poly_t *c1,
+               const poly_t *const d, size_t j0, size_t nd) {
+  const ring_t *r = c0->r;
+  size_t n = d->n;
+
+  n = c0->n < n ? c0->n : n;
+  n = c1->n < n ? c1->n : n;
+
+  OMP_FOR
+  for (size_t i = 0; i < n; ++i) {
+    const uint_t q = r->m[i], r64 = (-q) % q, r64p = shoup(r64, q);
+    const uint_t one = shoup(1, q);
+    const unsigned room = 128 - (bitlen(q) << 1);
+    const size_t chunk = room >= 64 ? SIZE_MAX : ((size_t)1 << room) - 1;
+    const size_t off = i << r->lgd;
+
+    for (size_t x = 0; x < r->d; ++x) {
+      uint_dt acc0 = 0, acc1 = 0;
+      uint_t v;
+
+      for (size_t j = 0, c = 0; j < nd; ++j) {
+        const bgv_keypair_t *p = k->k + j0 + j;
+        const uint_t w = d[j].b[off + x];
+        if (++c > chunk) {
+          acc0 = modred_wide(acc0, q, r64, r64p, one);
+          acc1 = modred_wide(acc1, q, r64, r64p, one);
+          c = 1;
+        }
+        acc0 += (uint_dt)w * p->b.b[off + x];
+        acc1 += (uint_dt)w * p->a.b[off + x];
+      }
+
+      v = c0->b[off + x] + modred_wide(acc0, q, r64, r64p, one);
+      c0->b[off + x] = const_time_select64(v >= q, v - q, v);
+      v = c1->b[off + x] + modred_wide(acc1, q, r64, r64p, one);
+      c1->b[off + x] = const_time_select64(v >= q, v - q, v);
+    }
+  }
+
+  /* The sums are in NTT form even when c1 started as a zero poly */
+  c0->n = c1->n = n;
+  c0->is_ntt = c1->is_ntt = 1;
+}
+
+int bgv_keyswitch(const bgv_ksk_t *const k, poly_t *c0, poly_t *c1,
+                  const poly_t *const x) {
+  /* One digit at a time, so the only temporaries are two pool buffers */
+  const size_t n = ksk_ndigits(k, x->n);
+  poly_t z, t;
+  int err;
+
+  /* Every allocation comes before c0 and c1 are touched */
+  if ((err = poly_zero(x->r, &t)))
+    return err;
+  if ((err = ksk_scale(k, &z, x))) {
+    poly_free(&t);
+    return err;
+  }
+
+  for (size_t j = 0; j < n; ++j) {
+    ksk_decompose(k, &t, &z, j, 1);
+    ksk_ntt(&t, 1);
+    ksk_apply(k, c0, c1, &t, j, 1);
+  }
+
+  poly_free(&z);
+  poly_free(&t);
+  return 0;
+}
+
+void bgv_ksk_free(bgv_ksk_t *k) {
+  if (k->k) {
+    for (size_t j = 0; j < k->dnum; ++j) {
+      poly_free(&k->k[j].a);
+      poly_free(&k->k[j].b);
+    }
+  }
+  free(k->k);
+  free(k->tab);
+  k->k = NULL;
+  k->tab = NULL;
+  k->dnum = k->alpha = 0;
+}
@@ -0,0 +1,69 @@
+// libfhe
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// This file contains the declaration of the two halves of a key switch.
+/// The digit decomposition only depends on the input polynomial, so it can
+/// be computed once and applied with several keys (hoisting).
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef BGV_KSK_H
+#define BGV_KSK_H
+
+#include "fhe_bgv.h"
+
+///
+/// \brief Offset in bgv_ksk_t.tab of the n(n + 1) constants of level n
+/// The tables of levels 1, ..., m - 1 take (m - 1) m (m + 1) / 3 words.
+///
+#define KSK_TAB_OFFSET(n) (((n) - 1) * (n) * ((n) + 1) / 3)
+
+///
+/// \brief Number of digits of a polynomial with n active limbs
+///
+static inline size_t ksk_ndigits(const bgv_ksk_t *const k, size_t n) {
+  return (n + k->alpha - 1) / k->alpha;
+}
+
+///
+/// \brief Gadget decomposition of a polynomial
+///
+/// \param k Key switching key, only its digit layout is used
+/// \param [out] d ksk_ndigits(k, x->n) uninitialized polynomials, the digits
+/// in NTT form at the level of x
+/// \param x Polynomial in NTT form
+///
+/// \returns 0 on success, -errno on allocation failure with d untouched.
+///
+int ksk_digits(const bgv_ksk_t *const k, poly_t *d, const poly_t *const x);
+
+///
+/// \brief Add \f$\sum_j d_j (b_{j_0 + j}, a_{j_0 + j})\f$ to \f$(c_0, c_1)\f$
+/// Products are accumulated unreduced as in poly_dot.
+///
+/// \param k Key switching key
+/// \param [in,out] c0 Constant ciphertext term
+/// \param [in,out] c1 Linear ciphertext term
+/// \param d Digits from ksk_digits, possibly permuted
+/// \param j0 Index of the first digit
+/// \param nd Number of digits
+///
+void ksk_apply(const bgv_ksk_t *const k, poly_t *c0, poly_t *c1,
+               const poly_t *const d, size_t j0, size_t nd);
+
+#endif /* BGV_KSK_H */
@@ -20,79 +20,170 @@
 ///
 //===----------------------------------------------------------------------===//
 
+#include <stdatomic.h>
+
 #include "fhe_poly.h"
 #include "fhe_ring.h"
 
-#include "utils/const_time.h"
-#include "utils/number_theory.h"
-
-void _ntt(uint_t *roots, uint_t *x, uint_t d, uint_t q, uint_t qinv) {
-  uint_t hi, lo, carry;
-  for (uint_t m = 1, t = d >> 1; m < d; m <<= 1, t >>= 1) {
-    for (uint_t i = 0, k = 0; i < m; ++i, k += (t << 1)) {
-      uint_t S = roots[m + i];
-      for (uint_t j = k; j < k + t; ++j) {
-        lo = mul64(x[j + t], S, &hi);
-        mul64(lo * qinv, q, &carry);
-        hi = const_time_select64(hi < carry, hi + q - carry, hi - carry);
-        x[j + t] = const_time_select64(x[j] < hi, x[j] + q - hi, x[j] - hi);
-        x[j] += hi;
-        x[j] = const_time_select64(x[j] > q, x[j] - q, x[j]);
-      }
-    }
+#include "ntt.h"
+
+/* Forward stages t, t / 2, ..., tmin on n blocks of stage m from block i0 */
+static void ntt_fwd_range(const ntt_impl_t *impl, const uint_t *w,
+                          const uint_t *wp, uint_t *x, uint_t m, uint_t t,
+                          uint_t i0, uint_t n, uint_t tmin, uint_t q) {
+  if (t < tmin)
+    return;
+
+  if (!(__builtin_ctzll(t / tmin) & 1)) {
+    impl->fwd(w + m + i0, wp + m + i0, x, n, t, q);
+    m <<= 1, i0 <<= 1, n <<= 1, t >>= 1;
   }
+
+  for (; t >= tmin; m <<= 2, i0 <<= 2, n <<= 2, t >>= 2)
+    impl->fwd4(w + m + i0, wp + m + i0, w + 2 * (m + i0), wp + 2 * (m + i0),
+               x, n, t >> 1, q);
 }
 
-void _intt(uint_t *iroots, uint_t *x, uint_t d, uint_t q, uint_t qinv,
-           uint_t dinv) {
-  uint_t hi, lo, carry;
-  for (uint_t m = d >> 1, t = 1; m > 0; m >>= 1, t <<= 1) {
-    for (uint_t i = 0, k = 0; i < m; ++i, k += (t << 1)) {
-      uint_t S = iroots[m + i];
-      for (uint_t j = k; j < k + t; ++j) {
-        carry = const_time_select64(x[j] < x[j + t], x[j] + q - x[j + t],
-                                    x[j] - x[j + t]);
-        x[j] += x[j + t];
-        x[j] = const_time_select64(x[j] > q, x[j] - q, x[j]);
-        lo = mul64(carry, S, &hi);
-        mul64(lo * qinv, q, &carry);
-        x[j + t] = const_time_select64(hi < carry, hi + q - carry, hi - carry);
-      }
-    }
+/* Inverse stages t, 2t, ..., tmax on n blocks of stage m from block i0 */
+static void ntt_inv_range(const ntt_impl_t *impl, const uint_t *w,
+                          const uint_t *wp, uint_t *x, uint_t m, uint_t t,
+                          uint_t i0, uint_t n, uint_t tmax, uint_t q) {
+  for (; (t << 1) <= tmax; m >>= 2, i0 >>= 2, n >>= 2, t <<= 2)
+    impl->inv4(w + ((m + i0) >> 1), wp + ((m + i0) >> 1), w + m + i0,
+               wp + m + i0, x, n >> 1, t, q);
+
+  if (t == tmax)
+    impl->inv(w + m + i0, wp + m + i0, x, n, t, q);
+}
+
+void _ntt(const ntt_impl_t *impl, const uint_t *w, const uint_t *wp,
+          uint_t *x, uint_t d, uint_t q) {
+  for (uint_t m = 1, t = d >> 1; m < d; m <<= 1, t >>= 1)
+    impl->fwd(w + m, wp + m, x, m, t, q);
+  impl->reduce(x, d, q);
+}
+
+void _intt(const ntt_impl_t *impl, const uint_t *w, const uint_t *wp,
+           uint_t *x, uint_t d, uint_t q, uint_t dinv, uint_t dinvp) {
+  for (uint_t m = d >> 1, t = 1; m > 0; m >>= 1, t <<= 1)
+    impl->inv(w + m, wp + m, x, m, t, q);
+  impl->scale(x, d, dinv, dinvp, q);
+}
+
+void _ntt_blocked(const ntt_impl_t *impl, const uint_t *w, const uint_t *wp,
+                  uint_t *x, uint_t d, uint_t q) {
+  const uint_t B = d < (1UL << NTT_BLOCK_LG) ? d : (1UL << NTT_BLOCK_LG);
+
+  ntt_fwd_range(impl, w, wp, x, 1, d >> 1, 0, 1, B, q);
+
+  for (uint_t b = 0; b < d / B; ++b) {
+    ntt_fwd_range(impl, w, wp, x + b * B, d / B, B >> 1, b, 1, 1, q);
+    impl->reduce(x + b * B, B, q);
   }
+}
 
-  for (uint_t i = 0; i < d; ++i) {
-    lo = mul64(x[i], dinv, &hi);
-    mul64(lo * qinv, q, &carry);
-    x[i] = const_time_select64(hi < carry, hi + q - carry, hi - carry);
+void _intt_blocked(const ntt_impl_t *impl, const uint_t *w, const uint_t *wp,
+                   uint_t *x, uint_t d, uint_t q, uint_t dinv, uint_t dinvp) {
+  const uint_t B = d < (1UL << NTT_BLOCK_LG) ? d : (1UL << NTT_BLOCK_LG);
+
+  for (uint_t b = 0; b < d / B; ++b)
+    ntt_inv_range(impl, w, wp, x + b * B, d >> 1, 1, b * (B >> 1), B >> 1,
+                  B >> 1, q);
+
+  ntt_inv_range(impl, w, wp, x, d / (B << 1), B, 0, d / (B << 1), d >> 1, q);
+  impl->scale(x, d, dinv, dinvp, q);
+}
+
+static const ntt_impl_t ntt_scalar = {
+    "scalar",       ntt_fwd_stage, ntt_fwd_stage4, ntt_inv_stage,
+    ntt_inv_stage4, ntt_reduce,    ntt_scale,
+};
+
+const ntt_impl_t *ntt_impl_isa(NTT_ISA isa) {
+  switch (isa) {
+  case NTT_SCALAR:
+    return &ntt_scalar;
+#ifdef FHE_X86_64
+  case NTT_AVX2:
+    return cpu_has_avx2() ? &ntt_avx2 : NULL;
+  case NTT_AVX512:
+    return cpu_has_avx512() ? &ntt_avx512 : NULL;
+#endif
+  default:
+    return NULL;
   }
 }
 
-void poly_ntt(poly_t *p) {
-  if (!p->is_ntt) {
-    ring_t *r = p->r;
+const ntt_impl_t *ntt_impl(void) {
+  /* Threads racing on the first call all store the same kernel */
+  static _Atomic(const ntt_impl_t *) impl = NULL;
+  const ntt_impl_t *best = atomic_load_explicit(&impl, memory_order_relaxed);
+
+  if (!best) {
+    for (int isa = NTT_ISA_COUNT - 1; !best; --isa)
+      best = ntt_impl_isa(isa);
+    atomic_store_explicit(&impl, best, memory_order_relaxed);
+  }
+  return best;
+}
+
+void ntt_limb(const ring_t *const r, uint_t *x, size_t i) {
+  const ntt_impl_t *impl = ntt_impl();
+  size_t offset = i << r->lgd;
+  if (r->d > (1UL << NTT_BLOCK_LG))
+    _ntt_blocked(impl, r->roots + offset, r->roots_shoup + offset, x, r->d,
+                 r->m[i]);
+  else
+    _ntt(impl, r->roots + offset, r->roots_shoup + offset, x, r->d, r->m[i]);
+}
+
+void intt_limb(const ring_t *const r, uint_t *x, size_t i) {
+  const ntt_impl_t *impl = ntt_impl();
+  size_t offset = i << r->lgd;
+  if (r->d > (1UL << NTT_BLOCK_LG))
+    _intt_blocked(impl, r->iroots + offset, r->iroots_shoup + offset, x, r->d,
+                  r->m[i], r->dinv[i], r->dinv_shoup[i]);
+  else
+    _intt(impl, r->iroots + offset, r->iroots_shoup + offset, x, r->d,
+          r->m[i], r->dinv[i], r->dinv_shoup[i]);
+}
+
+void poly_ntt_batch(poly_t *const *p, size_t k) {
+  if (k) {
+    ring_t *r = p[0]->r;
+    ntt_impl(); /* Resolve the kernel before entering the parallel region */
 
     OMP_FOR
-    for (size_t i = 0; i < r->n; ++i) {
-      int offset = i << r->lgd;
-      _ntt(r->roots + offset, p->b + offset, r->d, r->m[i], r->minv[i]);
+    for (size_t j = 0; j < k * r->n; ++j) {
+      poly_t *x = p[j / r->n];
+      size_t i = j % r->n;
+      if (!x->is_ntt && i < x->n)
+        ntt_limb(r, x->b + (i << r->lgd), i);
     }
 
-    p->is_ntt = 1;
+    for (size_t j = 0; j < k; ++j)
+      p[j]->is_ntt = 1;
   }
 }
 
-void poly_intt(poly_t *p) {
-  if (p->is_ntt) {
-    ring_t *r = p->r;
+void poly_intt_batch(poly_t *const *p, size_t k) {
+  if (k) {
+    ring_t *r = p[0]->r;
+    ntt_impl();
 
     OMP_FOR
-    for (size_t i = 0; i < r->n; ++i) {
-      int offset = i << r->lgd;
-      _intt(r->iroots + offset, p->b + offset, r->d, r->m[i], r->minv[i],
-            r->dinv[i]);
+    for (size_t j = 0; j < k * r->n; ++j) {
+      poly_t *x = p[j / r->n];
+      size_t i = j % r->n;
+      if (x->is_ntt && i < x->n)
+        intt_limb(r, x->b + (i << r->lgd), i);
     }
 
-    p->is_ntt = 0;
+    for (size_t j = 0; j < k; ++j)
+      p[j]->is_ntt = 0;
   }
 }
+
+void poly_ntt(poly_t *p) { poly_ntt_batch(&p, 1); }
+
+void poly_intt(poly_t *p) { poly_intt_batch(&p, 1); }
@@ -0,0 +1,225 @@
+// libfhe
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// This file contains the declaration of the number theoretic transform
+/// kernels and their runtime dispatch.
+///
+/// All kernels operate on a single residue of d coefficients modulo q
+/// following Harvey's lazy reduction strategy: coefficients stay in
+/// [0, 4q) between stages and twiddle products use precomputed Shoup
+/// companions (see ring_init). Inputs and outputs are fully reduced.
+/// Scalar kernels require q < 2^62, vector kernels q < 2^61 so that
+/// intermediate values fit in a signed 64 bit lane.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef NTT_H
+#define NTT_H
+
+#include "fhe_config.h"
+#include "fhe_ring.h"
+
+#include "utils/const_time.h"
+#include "utils/cpu.h"
+#include "utils/number_theory.h"
+
+///
+/// \brief log2 of the block size (in coefficients) below which the
+/// remaining forward stages, or the first inverse stages, run block by
+/// block so that each block stays in cache.
+///
+#define NTT_BLOCK_LG 11
+
+/* Radix-2 stage over n blocks of 2t coefficients, block i uses w[i] */
+typedef void (*ntt_stage_fn)(const uint_t *w, const uint_t *wp, uint_t *x,
+                             uint_t n, uint_t t, uint_t q);
+
+/* Two merged radix-2 stages over n blocks of 4t coefficients */
+typedef void (*ntt_stage4_fn)(const uint_t *w1, const uint_t *w1p,
+                              const uint_t *w2, const uint_t *w2p, uint_t *x,
+                              uint_t n, uint_t t, uint_t q);
+
+/* x[i] mod q, for x[i] in [0, 4q) */
+typedef void (*ntt_reduce_fn)(uint_t *x, uint_t len, uint_t q);
+
+/* c * x[i] mod q, for x[i] in [0, 4q) */
+typedef void (*ntt_scale_fn)(uint_t *x, uint_t len, uint_t c, uint_t cp,
+                             uint_t q);
+
+///
+/// \brief Instruction sets with a dedicated NTT kernel
+///
+typedef enum NTT_ISA {
+  NTT_SCALAR = 0,
+  NTT_AVX2,
+  NTT_AVX512,
+  NTT_ISA_COUNT,
+} NTT_ISA;
+
+///
+/// \brief Butterfly kernels for one instruction set
+///
+/// Forward stages are Cooley-Tukey butterflies taking and returning
+/// values in [0, 4q), inverse stages are Gentleman-Sande butterflies
+/// taking and returning values in [0, 2q). A merged forward stage with
+/// twiddles w1 is followed by the stage with twiddles w2[2i], w2[2i + 1]
+/// on the two halves of block i. A merged inverse stage runs in the
+/// opposite order.
+///
+typedef struct ntt_impl_t {
+  const char *name;     ///< Human readable kernel name
+  ntt_stage_fn fwd;     ///< Radix-2 forward stage
+  ntt_stage4_fn fwd4;   ///< Radix-4 forward stage
+  ntt_stage_fn inv;     ///< Radix-2 inverse stage
+  ntt_stage4_fn inv4;   ///< Radix-4 inverse stage
+  ntt_reduce_fn reduce; ///< Final forward reduction
+  ntt_scale_fn scale;   ///< Final inverse scaling
+} ntt_impl_t;
+
+/* Forward butterfly on u, v in [0, 4q) */
+static inline void ntt_fwd_bfly(uint_t *x, uint_t *y, uint_t W, uint_t Wp,
+                                uint_t q) {
+  const uint_t q2 = q << 1;
+  uint_t u = const_time_select64(*x >= q2, *x - q2, *x);
+  uint_t v = mulmod_shoup_lazy(*y, W, Wp, q);
+  *x = u + v;
+  *y = u - v + q2;
+}
+
+/* Inverse butterfly on u, v in [0, 2q) */
+static inline void ntt_inv_bfly(uint_t *x, uint_t *y, uint_t W, uint_t Wp,
+                                uint_t q) {
+  const uint_t q2 = q << 1;
+  uint_t u = *x, v = *y;
+  *x = const_time_select64(u + v >= q2, u + v - q2, u + v);
+  *y = mulmod_shoup_lazy(u - v + q2, W, Wp, q);
+}
+
+/* Reduce x in [0, 4q) to [0, q) */
+static inline uint_t ntt_reduce4q(uint_t x, uint_t q) {
+  x = const_time_select64(x >= (q << 1), x - (q << 1), x);
+  return const_time_select64(x >= q, x - q, x);
+}
+
+static inline void ntt_fwd_stage(const uint_t *w, const uint_t *wp, uint_t *x,
+                                 uint_t n, uint_t t, uint_t q) {
+  for (uint_t i = 0; i < n; ++i, x += (t << 1))
+    for (uint_t j = 0; j < t; ++j)
+      ntt_fwd_bfly(x + j, x + j + t, w[i], wp[i], q);
+}
+
+static inline void ntt_inv_stage(const uint_t *w, const uint_t *wp, uint_t *x,
+                                 uint_t n, uint_t t, uint_t q) {
+  for (uint_t i = 0; i < n; ++i, x += (t << 1))
+    for (uint_t j = 0; j < t; ++j)
+      ntt_inv_bfly(x + j, x + j + t, w[i], wp[i], q);
+}
+
+static inline void ntt_fwd_stage4(const uint_t *w1, const uint_t *w1p,
+                                  const uint_t *w2, const uint_t *w2p,
+                                  uint_t *x, uint_t n, uint_t t, uint_t q) {
+  for (uint_t i = 0; i < n; ++i, x += (t << 2)) {
+    for (uint_t j = 0; j < t; ++j) {
+      uint_t *a = x + j, *b = a + t, *c = b + t, *d = c + t;
+      ntt_fwd_bfly(a, c, w1[i], w1p[i], q);
+      ntt_fwd_bfly(b, d, w1[i], w1p[i], q);
+      ntt_fwd_bfly(a, b, w2[2 * i], w2p[2 * i], q);
+      ntt_fwd_bfly(c, d, w2[2 * i + 1], w2p[2 * i + 1], q);
+    }
+  }
+}
+
+static inline void ntt_inv_stage4(const uint_t *w1, const uint_t *w1p,
+                                  const uint_t *w2, const uint_t *w2p,
+                                  uint_t *x, uint_t n, uint_t t, uint_t q) {
+  for (uint_t i = 0; i < n; ++i, x += (t << 2)) {
+    for (uint_t j = 0; j < t; ++j) {
+      uint_t *a = x + j, *b = a + t, *c = b + t, *d = c + t;
+      ntt_inv_bfly(a, b, w2[2 * i], w2p[2 * i], q);
+      ntt_inv_bfly(c, d, w2[2 * i + 1], w2p[2 * i + 1], q);
+      ntt_inv_bfly(a, c, w1[i], w1p[i], q);
+      ntt_inv_bfly(b, d, w1[i], w1p[i], q);
+    }
+  }
+}
+
+static inline void ntt_reduce(uint_t *x, uint_t len, uint_t q) {
+  for (uint_t i = 0; i < len; ++i)
+    x[i] = ntt_reduce4q(x[i], q);
+}
+
+static inline void ntt_scale(uint_t *x, uint_t len, uint_t c, uint_t cp,
+                             uint_t q) {
+  for (uint_t i = 0; i < len; ++i)
+    x[i] = ntt_reduce4q(mulmod_shoup_lazy(x[i], c, cp, q), q);
+}
+
+#ifdef FHE_X86_64
+extern const ntt_impl_t ntt_avx2;
+extern const ntt_impl_t ntt_avx512;
+#endif
+
+///
+/// \brief Radix-2 forward transform, one pass over x per stage
+///
+void _ntt(const ntt_impl_t *impl, const uint_t *w, const uint_t *wp,
+          uint_t *x, uint_t d, uint_t q);
+
+///
+/// \brief Radix-2 inverse transform, one pass over x per stage
+///
+void _intt(const ntt_impl_t *impl, const uint_t *w, const uint_t *wp,
+           uint_t *x, uint_t d, uint_t q, uint_t dinv, uint_t dinvp);
+
+///
+/// \brief Cache blocked forward transform.
+/// Stages on blocks larger than 2^NTT_BLOCK_LG are merged pairwise,
+/// the remaining stages run block by block.
+///
+void _ntt_blocked(const ntt_impl_t *impl, const uint_t *w, const uint_t *wp,
+                  uint_t *x, uint_t d, uint_t q);
+
+///
+/// \brief Cache blocked inverse transform
+///
+void _intt_blocked(const ntt_impl_t *impl, const uint_t *w, const uint_t *wp,
+                   uint_t *x, uint_t d, uint_t q, uint_t dinv, uint_t dinvp);
+
+///
+/// \brief Forward transform of residue i of a polynomial over r
+///
+void ntt_limb(const ring_t *const r, uint_t *x, size_t i);
+
+///
+/// \brief Inverse transform of residue i of a polynomial over r
+///
+void intt_limb(const ring_t *const r, uint_t *x, size_t i);
+
+///
+/// \brief Kernel for a given instruction set
+///
+/// \returns NULL if the kernel is not built or not supported by this CPU
+///
+const ntt_impl_t *ntt_impl_isa(NTT_ISA isa);
+
+///
+/// \brief Fastest kernel supported by this CPU
+///
+const ntt_impl_t *ntt_impl(void);
+
+#endif /* NTT_H */
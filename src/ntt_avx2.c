@@ -0,0 +1,226 @@
+// libfhe
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// This file implements the number theoretic transform using AVX2.
+///
+/// AVX2 has no 64 bit multiply, so the Shoup products are assembled
+/// from 32x32 bit products. Stages with fewer than four butterflies
+/// per twiddle fall back to the scalar kernel.
+///
+//===----------------------------------------------------------------------===//
+
+#include "ntt.h"
+
+#ifdef FHE_X86_64
+
+#include <immintrin.h>
+
+#define LANES 4
+
+static inline TARGET_AVX2 __m256i mul_hi(__m256i a, __m256i b) {
+  const __m256i lo32 = _mm256_set1_epi64x(0xffffffff);
+  __m256i ah = _mm256_srli_epi64(a, 32);
+  __m256i bh = _mm256_srli_epi64(b, 32);
+  __m256i p00 = _mm256_mul_epu32(a, b);
+  __m256i p01 = _mm256_mul_epu32(a, bh);
+  __m256i p10 = _mm256_mul_epu32(ah, b);
+  __m256i p11 = _mm256_mul_epu32(ah, bh);
+  __m256i mid = _mm256_add_epi64(_mm256_srli_epi64(p00, 32),
+                                 _mm256_and_si256(p01, lo32));
+  mid = _mm256_add_epi64(mid, _mm256_and_si256(p10, lo32));
+  __m256i hi = _mm256_add_epi64(p11, _mm256_srli_epi64(p01, 32));
+  hi = _mm256_add_epi64(hi, _mm256_srli_epi64(p10, 32));
+  return _mm256_add_epi64(hi, _mm256_srli_epi64(mid, 32));
+}
+
+static inline TARGET_AVX2 __m256i mul_lo(__m256i a, __m256i b) {
+  __m256i cross = _mm256_add_epi64(
+      _mm256_mul_epu32(a, _mm256_srli_epi64(b, 32)),
+      _mm256_mul_epu32(_mm256_srli_epi64(a, 32), b));
+  return _mm256_add_epi64(_mm256_mul_epu32(a, b),
+                          _mm256_slli_epi64(cross, 32));
+}
+
+/* Lane-wise mulmod_shoup_lazy */
+static inline TARGET_AVX2 __m256i mulmod_shoup(__m256i x, __m256i w,
+                                               __m256i wp, __m256i q) {
+  __m256i hi = mul_hi(x, wp);
+  return _mm256_sub_epi64(mul_lo(x, w), mul_lo(hi, q));
+}
+
+/* x - c if x >= c, with cm1 = c - 1 */
+static inline TARGET_AVX2 __m256i csub(__m256i x, __m256i c, __m256i cm1) {
+  __m256i ge = _mm256_cmpgt_epi64(x, cm1);
+  return _mm256_sub_epi64(x, _mm256_and_si256(ge, c));
+}
+
+typedef struct vq_t {
+  __m256i q, qm1, q2, q2m1;
+} vq_t;
+
+static inline TARGET_AVX2 vq_t vq_set(uint_t q) {
+  vq_t v = {_mm256_set1_epi64x(q), _mm256_set1_epi64x(q - 1),
+            _mm256_set1_epi64x(q << 1), _mm256_set1_epi64x((q << 1) - 1)};
+  return v;
+}
+
+/* Lane-wise ntt_fwd_bfly */
+static inline TARGET_AVX2 void fwd_bfly(__m256i *x, __m256i *y, __m256i W,
+                                        __m256i Wp, const vq_t *q) {
+  __m256i u = csub(*x, q->q2, q->q2m1);
+  __m256i v = mulmod_shoup(*y, W, Wp, q->q);
+  *x = _mm256_add_epi64(u, v);
+  *y = _mm256_add_epi64(_mm256_sub_epi64(u, v), q->q2);
+}
+
+/* Lane-wise ntt_inv_bfly */
+static inline TARGET_AVX2 void inv_bfly(__m256i *x, __m256i *y, __m256i W,
+                                        __m256i Wp, const vq_t *q) {
+  __m256i u = *x, v = *y;
+  *x = csub(_mm256_add_epi64(u, v), q->q2, q->q2m1);
+  *y = mulmod_shoup(_mm256_add_epi64(_mm256_sub_epi64(u, v), q->q2), W, Wp,
+                    q->q);
+}
+
+#define LOAD(p) _mm256_loadu_si256((const __m256i *)(p))
+#define STORE(p, v) _mm256_storeu_si256((__m256i *)(p), v)
+#define BCAST(v) _mm256_set1_epi64x(v)
+
+static TARGET_AVX2 void fwd2(const uint_t *w, const uint_t *wp, uint_t *x,
+                            uint_t n, uint_t t, uint_t q) {
+  if (t < LANES) {
+    ntt_fwd_stage(w, wp, x, n, t, q);
+    return;
+  }
+
+  const vq_t vq = vq_set(q);
+  for (uint_t i = 0; i < n; ++i, x += (t << 1)) {
+    const __m256i W = BCAST(w[i]), Wp = BCAST(wp[i]);
+    for (uint_t j = 0; j < t; j += LANES) {
+      __m256i a = LOAD(x + j), b = LOAD(x + j + t);
+      fwd_bfly(&a, &b, W, Wp, &vq);
+      STORE(x + j, a);
+      STORE(x + j + t, b);
+    }
+  }
+}
+
+static TARGET_AVX2 void fwd4(const uint_t *w1, const uint_t *w1p,
+                             const uint_t *w2, const uint_t *w2p, uint_t *x,
+                             uint_t n, uint_t t, uint_t q) {
+  if (t < LANES) {
+    fwd2(w1, w1p, x, n, t << 1, q);
+    fwd2(w2, w2p, x, n << 1, t, q);
+    return;
+  }
+
+  const vq_t vq = vq_set(q);
+  for (uint_t i = 0; i < n; ++i, x += (t << 2)) {
+    const __m256i W1 = BCAST(w1[i]), W1p = BCAST(w1p[i]);
+    const __m256i W2 = BCAST(w2[2 * i]), W2p = BCAST(w2p[2 * i]);
+    const __m256i W3 = BCAST(w2[2 * i + 1]), W3p = BCAST(w2p[2 * i + 1]);
+    for (uint_t j = 0; j < t; j += LANES) {
+      uint_t *p = x + j;
+      __m256i a = LOAD(p), b = LOAD(p + t);
+      __m256i c = LOAD(p + 2 * t), d = LOAD(p + 3 * t);
+      fwd_bfly(&a, &c, W1, W1p, &vq);
+      fwd_bfly(&b, &d, W1, W1p, &vq);
+      fwd_bfly(&a, &b, W2, W2p, &vq);
+      fwd_bfly(&c, &d, W3, W3p, &vq);
+      STORE(p, a);
+      STORE(p + t, b);
+      STORE(p + 2 * t, c);
+      STORE(p + 3 * t, d);
+    }
+  }
+}
+
+static TARGET_AVX2 void inv2(const uint_t *w, const uint_t *wp, uint_t *x,
+                            uint_t n, uint_t t, uint_t q) {
+  if (t < LANES) {
+    ntt_inv_stage(w, wp, x, n, t, q);
+    return;
+  }
+
+  const vq_t vq = vq_set(q);
+  for (uint_t i = 0; i < n; ++i, x += (t << 1)) {
+    const __m256i W = BCAST(w[i]), Wp = BCAST(wp[i]);
+    for (uint_t j = 0; j < t; j += LANES) {
+      __m256i a = LOAD(x + j), b = LOAD(x + j + t);
+      inv_bfly(&a, &b, W, Wp, &vq);
+      STORE(x + j, a);
+      STORE(x + j + t, b);
+    }
+  }
+}
+
+static TARGET_AVX2 void inv4(const uint_t *w1, const uint_t *w1p,
+                             const uint_t *w2, const uint_t *w2p, uint_t *x,
+                             uint_t n, uint_t t, uint_t q) {
+  if (t < LANES) {
+    inv2(w2, w2p, x, n << 1, t, q);
+    inv2(w1, w1p, x, n, t << 1, q);
+    return;
+  }
+
+  const vq_t vq = vq_set(q);
+  for (uint_t i = 0; i < n; ++i, x += (t << 2)) {
+    const __m256i W1 = BCAST(w1[i]), W1p = BCAST(w1p[i]);
+    const __m256i W2 = BCAST(w2[2 * i]), W2p = BCAST(w2p[2 * i]);
+    const __m256i W3 = BCAST(w2[2 * i + 1]), W3p = BCAST(w2p[2 * i + 1]);
+    for (uint_t j = 0; j < t; j += LANES) {
+      uint_t *p = x + j;
+      __m256i a = LOAD(p), b = LOAD(p + t);
+      __m256i c = LOAD(p + 2 * t), d = LOAD(p + 3 * t);
+      inv_bfly(&a, &b, W2, W2p, &vq);
+      inv_bfly(&c, &d, W3, W3p, &vq);
+      inv_bfly(&a, &c, W1, W1p, &vq);
+      inv_bfly(&b, &d, W1, W1p, &vq);
+      STORE(p, a);
+      STORE(p + t, b);
+      STORE(p + 2 * t, c);
+      STORE(p + 3 * t, d);
+    }
+  }
+}
+
+static TARGET_AVX2 void reduce(uint_t *x, uint_t len, uint_t q) {
+  const vq_t vq = vq_set(q);
+  uint_t i = 0;
+  for (; i + LANES <= len; i += LANES) {
+    __m256i v = csub(LOAD(x + i), vq.q2, vq.q2m1);
+    STORE(x + i, csub(v, vq.q, vq.qm1));
+  }
+  ntt_reduce(x + i, len - i, q);
+}
+
+static TARGET_AVX2 void scale(uint_t *x, uint_t len, uint_t c, uint_t cp,
+                              uint_t q) {
+  const vq_t vq = vq_set(q);
+  const __m256i C = BCAST(c), Cp = BCAST(cp);
+  uint_t i = 0;
+  for (; i + LANES <= len; i += LANES) {
+    __m256i v = mulmod_shoup(LOAD(x + i), C, Cp, vq.q);
+    STORE(x + i, csub(v, vq.q, vq.qm1));
+  }
+  ntt_scale(x + i, len - i, c, cp, q);
+}
+
+const ntt_impl_t ntt_avx2 = {"avx2", fwd2, fwd4, inv2, inv4, reduce, scale};
+
+#endif /* FHE_X86_64 */
@@ -0,0 +1,203 @@
+// libfhe
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// This file implements the number theoretic transform using AVX-512.
+///
+/// Low products use the AVX-512DQ 64 bit multiply, the high half of the
+/// Shoup product is assembled from 32x32 bit products. Stages with fewer
+/// than eight butterflies per twiddle fall back to the scalar kernel.
+///
+//===----------------------------------------------------------------------===//
+
+#include "ntt.h"
+
+#ifdef FHE_X86_64
+
+#include <immintrin.h>
+
+#define LANES 8
+
+static inline TARGET_AVX512 __m512i mul_hi(__m512i a, __m512i b) {
+  const __m512i lo32 = _mm512_set1_epi64(0xffffffff);
+  __m512i ah = _mm512_srli_epi64(a, 32);
+  __m512i bh = _mm512_srli_epi64(b, 32);
+  __m512i p00 = _mm512_mul_epu32(a, b);
+  __m512i p01 = _mm512_mul_epu32(a, bh);
+  __m512i p10 = _mm512_mul_epu32(ah, b);
+  __m512i p11 = _mm512_mul_epu32(ah, bh);
+  __m512i mid = _mm512_add_epi64(_mm512_srli_epi64(p00, 32),
+                                 _mm512_and_si512(p01, lo32));
+  mid = _mm512_add_epi64(mid, _mm512_and_si512(p10, lo32));
+  __m512i hi = _mm512_add_epi64(p11, _mm512_srli_epi64(p01, 32));
+  hi = _mm512_add_epi64(hi, _mm512_srli_epi64(p10, 32));
+  return _mm512_add_epi64(hi, _mm512_srli_epi64(mid, 32));
+}
+
+/* Lane-wise mulmod_shoup_lazy */
+static inline TARGET_AVX512 __m512i mulmod_shoup(__m512i x, __m512i w,
+                                                 __m512i wp, __m512i q) {
+  __m512i hi = mul_hi(x, wp);
+  return _mm512_sub_epi64(_mm512_mullo_epi64(x, w),
+                          _mm512_mullo_epi64(hi, q));
+}
+
+/* x - c if x >= c */
+static inline TARGET_AVX512 __m512i csub(__m512i x, __m512i c) {
+  return _mm512_min_epu64(x, _mm512_sub_epi64(x, c));
+}
+
+/* Lane-wise ntt_fwd_bfly */
+static inline TARGET_AVX512 void fwd_bfly(__m512i *x, __m512i *y, __m512i W,
+                                          __m512i Wp, __m512i q, __m512i q2) {
+  __m512i u = csub(*x, q2);
+  __m512i v = mulmod_shoup(*y, W, Wp, q);
+  *x = _mm512_add_epi64(u, v);
+  *y = _mm512_add_epi64(_mm512_sub_epi64(u, v), q2);
+}
+
+/* Lane-wise ntt_inv_bfly */
+static inline TARGET_AVX512 void inv_bfly(__m512i *x, __m512i *y, __m512i W,
+                                          __m512i Wp, __m512i q, __m512i q2) {
+  __m512i u = *x, v = *y;
+  *x = csub(_mm512_add_epi64(u, v), q2);
+  *y = mulmod_shoup(_mm512_add_epi64(_mm512_sub_epi64(u, v), q2), W, Wp, q);
+}
+
+#define LOAD(p) _mm512_loadu_si512(p)
+#define STORE(p, v) _mm512_storeu_si512(p, v)
+#define BCAST(v) _mm512_set1_epi64(v)
+
+static TARGET_AVX512 void fwd2(const uint_t *w, const uint_t *wp, uint_t *x,
+                              uint_t n, uint_t t, uint_t q) {
+  if (t < LANES) {
+    ntt_fwd_stage(w, wp, x, n, t, q);
+    return;
+  }
+
+  const __m512i vq = BCAST(q), vq2 = BCAST(q << 1);
+  for (uint_t i = 0; i < n; ++i, x += (t << 1)) {
+    const __m512i W = BCAST(w[i]), Wp = BCAST(wp[i]);
+    for (uint_t j = 0; j < t; j += LANES) {
+      __m512i a = LOAD(x + j), b = LOAD(x + j + t);
+      fwd_bfly(&a, &b, W, Wp, vq, vq2);
+      STORE(x + j, a);
+      STORE(x + j + t, b);
+    }
+  }
+}
+
+static TARGET_AVX512 void fwd4(const uint_t *w1, const uint_t *w1p,
+                               const uint_t *w2, const uint_t *w2p, uint_t *x,
+                               uint_t n, uint_t t, uint_t q) {
+  if (t < LANES) {
+    fwd2(w1, w1p, x, n, t << 1, q);
+    fwd2(w2, w2p, x, n << 1, t, q);
+    return;
+  }
+
+  const __m512i vq = BCAST(q), vq2 = BCAST(q << 1);
+  for (uint_t i = 0; i < n; ++i, x += (t << 2)) {
+    const __m512i W1 = BCAST(w1[i]), W1p = BCAST(w1p[i]);
+    const __m512i W2 = BCAST(w2[2 * i]), W2p = BCAST(w2p[2 * i]);
+    const __m512i W3 = BCAST(w2[2 * i + 1]), W3p = BCAST(w2p[2 * i + 1]);
+    for (uint_t j = 0; j < t; j += LANES) {
+      uint_t *p = x + j;
+      __m512i a = LOAD(p), b = LOAD(p + t);
+      __m512i c = LOAD(p + 2 * t), d = LOAD(p + 3 * t);
+      fwd_bfly(&a, &c, W1, W1p, vq, vq2);
+      fwd_bfly(&b, &d, W1, W1p, vq, vq2);
+      fwd_bfly(&a, &b, W2, W2p, vq, vq2);
+      fwd_bfly(&c, &d, W3, W3p, vq, vq2);
+      STORE(p, a);
+      STORE(p + t, b);
+      STORE(p + 2 * t, c);
+      STORE(p + 3 * t, d);
+    }
+  }
+}
+
+static TARGET_AVX512 void inv2(const uint_t *w, const uint_t *wp, uint_t *x,
+                              uint_t n, uint_t t, uint_t q) {
+  if (t < LANES) {
+    ntt_inv_stage(w, wp, x, n, t, q);
+    return;
+  }
+
+  const __m512i vq = BCAST(q), vq2 = BCAST(q << 1);
+  for (uint_t i = 0; i < n; ++i, x += (t << 1)) {
+    const __m512i W = BCAST(w[i]), Wp = BCAST(wp[i]);
+    for (uint_t j = 0; j < t; j += LANES) {
+      __m512i a = LOAD(x + j), b = LOAD(x + j + t);
+      inv_bfly(&a, &b, W, Wp, vq, vq2);
+      STORE(x + j, a);
+      STORE(x + j + t, b);
+    }
+  }
+}
+
+static TARGET_AVX512 void inv4(const uint_t *w1, const uint_t *w1p,
+                               const uint_t *w2, const uint_t *w2p, uint_t *x,
+                               uint_t n, uint_t t, uint_t q) {
+  if (t < LANES) {
+    inv2(w2, w2p, x, n << 1, t, q);
+    inv2(w1, w1p, x, n, t << 1, q);
+    return;
+  }
+
+  const __m512i vq = BCAST(q), vq2 = BCAST(q << 1);
+  for (uint_t i = 0; i < n; ++i, x += (t << 2)) {
+    const __m512i W1 = BCAST(w1[i]), W1p = BCAST(w1p[i]);
+    const __m512i W2 = BCAST(w2[2 * i]), W2p = BCAST(w2p[2 * i]);
+    const __m512i W3 = BCAST(w2[2 * i + 1]), W3p = BCAST(w2p[2 * i + 1]);
+    for (uint_t j = 0; j < t; j += LANES) {
+      uint_t *p = x + j;
+      __m512i a = LOAD(p), b = LOAD(p + t);
+      __m512i c = LOAD(p + 2 * t), d = LOAD(p + 3 * t);
+      inv_bfly(&a, &b, W2, W2p, vq, vq2);
+      inv_bfly(&c, &d, W3, W3p, vq, vq2);
+      inv_bfly(&a, &c, W1, W1p, vq, vq2);
+      inv_bfly(&b, &d, W1, W1p, vq, vq2);
+      STORE(p, a);
+      STORE(p + t, b);
+      STORE(p + 2 * t, c);
+      STORE(p + 3 * t, d);
+    }
+  }
+}
+
+static TARGET_AVX512 void reduce(uint_t *x, uint_t len, uint_t q) {
+  const __m512i vq = BCAST(q), vq2 = BCAST(q << 1);
+  uint_t i = 0;
+  for (; i + LANES <= len; i += LANES)
+    STORE(x + i, csub(csub(LOAD(x + i), vq2), vq));
+  ntt_reduce(x + i, len - i, q);
+}
+
+static TARGET_AVX512 void scale(uint_t *x, uint_t len, uint_t c, uint_t cp,
+                                uint_t q) {
+  const __m512i vq = BCAST(q), C = BCAST(c), Cp = BCAST(cp);
+  uint_t i = 0;
+  for (; i + LANES <= len; i += LANES)
+    STORE(x + i, csub(mulmod_shoup(LOAD(x + i), C, Cp, vq), vq));
+  ntt_scale(x + i, len - i, c, cp, q);
+}
+
+const ntt_impl_t ntt_avx512 = {"avx512", fwd2,   fwd4, inv2,
+                               inv4,     reduce, scale};
+
+#endif /* FHE_X86_64 */
@@ -22,105 +22,615 @@
 //===----------------------------------------------------------------------===//
 
 #include <errno.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "fhe_config.h"
 #include "fhe_poly.h"
 
+#include "ntt.h"
+#include "pool.h"
 #include "rand/sample.h"
 #include "utils/number_theory.h"
 
+/* Coefficients decoded together, limb by limb */
+#define DECODE_BLOCK 256
+/* Coefficients sampled together by poly_rand_rng */
+#define RAND_CHUNK 1024
+
 #define POLY_BINOP(C, A, B, BINOP)                                             \
   do {                                                                         \
     ring_t *r = (C)->r;                                                        \
+    const size_t n = (A)->n < (B)->n ? (A)->n : (B)->n;                        \
     OMP_FOR                                                                    \
-    for (size_t i = 0; i < r->n; ++i) {                                        \
-      for (size_t j = 0; j < r->d; ++j) {                                      \
-        size_t index = (i << r->lgd) + j;                                      \
-        (C)->b[index] = BINOP((A)->b[index], (B)->b[index], r->m[i]);          \
-      }                                                                        \
+    for (size_t i = 0; i < n; ++i) {                                           \
+      const uint_t q = r->m[i], mu = r->barrett[i];                            \
+      const uint_t *x = (A)->b + (i << r->lgd), *y = (B)->b + (i << r->lgd);   \
+      uint_t *z = (C)->b + (i << r->lgd);                                      \
+      for (size_t j = 0; j < r->d; ++j)                                        \
+        z[j] = BINOP(x[j], y[j], q, mu);                                       \
     }                                                                          \
     (C)->is_ntt = A->is_ntt | B->is_ntt;                                       \
+    (C)->n = n;                                                                \
   } while (0)
 
-int poly_zero(const ring_t *const r, poly_t *p) {
-  if (!(p->b = calloc(1, (sizeof(int_t) * r->n) << r->lgd)))
+#define POLY_TERNOP(D, A, B, C, TERNOP)                                        \
+  do {                                                                         \
+    ring_t *r = (D)->r;                                                        \
+    size_t n = (A)->n < (B)->n ? (A)->n : (B)->n;                              \
+    n = n < (C)->n ? n : (C)->n;                                               \
+    OMP_FOR                                                                    \
+    for (size_t i = 0; i < n; ++i) {                                           \
+      const uint_t q = r->m[i], mu = r->barrett[i];                            \
+      const uint_t *x = (A)->b + (i << r->lgd), *y = (B)->b + (i << r->lgd);   \
+      const uint_t *z = (C)->b + (i << r->lgd);                                \
+      uint_t *w = (D)->b + (i << r->lgd);                                      \
+      for (size_t j = 0; j < r->d; ++j)                                        \
+        w[j] = TERNOP(x[j], y[j], z[j], q, mu);                                \
+    }                                                                          \
+    (D)->is_ntt = A->is_ntt | B->is_ntt | C->is_ntt;                           \
+    (D)->n = n;                                                                \
+  } while (0)
+
+/* Element-wise kernels, operands are reduced mod q */
+static inline uint_t add_op(uint_t a, uint_t b, uint_t q, uint_t mu) {
+  (void)mu;
+  return modadd_ct(a, b, q);
+}
+
+static inline uint_t sub_op(uint_t a, uint_t b, uint_t q, uint_t mu) {
+  (void)mu;
+  return modsub_ct(a, b, q);
+}
+
+static inline uint_t mul_op(uint_t a, uint_t b, uint_t q, uint_t mu) {
+  return modmul_barrett(a, b, q, mu);
+}
+
+/* a * b + c < 2^2L is reduced once */
+static inline uint_t mul_add_op(uint_t a, uint_t b, uint_t c, uint_t q,
+                                uint_t mu) {
+  return modred_barrett((uint_dt)a * b + c, q, mu);
+}
+
+static inline uint_t mul_sub_op(uint_t a, uint_t b, uint_t c, uint_t q,
+                                uint_t mu) {
+  return modsub_ct(c, modmul_barrett(a, b, q, mu), q);
+}
+
+/* Attach an uninitialized coefficient buffer to p */
+static int poly_alloc(const ring_t *const r, poly_t *p) {
+  if (!(p->b = pool_get(r)))
     return -errno;
   p->r = (ring_t *)r;
+  p->n = r->n;
   p->is_ntt = 0;
   return 0;
 }
 
+int poly_zero(const ring_t *const r, poly_t *p) {
+  int err = poly_alloc(r, p);
+  if (!err)
+    memset(p->b, 0, (sizeof(uint_t) * r->n) << r->lgd);
+  return err;
+}
+
 void poly_clone(poly_t *dst, const poly_t *const src) {
-  poly_zero(src->r, dst);
-  for (unsigned i = 0; i < src->r->d * src->r->n; ++i) {
-    dst->b[i] = src->b[i];
+  if (!poly_alloc(src->r, dst)) {
+    memcpy(dst->b, src->b, (sizeof(uint_t) * src->n) << src->r->lgd);
+    dst->is_ntt = src->is_ntt;
+    dst->n = src->n;
+  }
+}
+
+void poly_copy(poly_t *dst, const poly_t *const src) {
+  if (dst != src) {
+    memcpy(dst->b, src->b, (sizeof(uint_t) * src->n) << src->r->lgd);
+    dst->is_ntt = src->is_ntt;
+    dst->n = src->n;
   }
-  dst->is_ntt = src->is_ntt;
+}
+
+/* y = s mod q for |s| < q, y may alias s */
+static inline void poly_lift(uint_t *y, const int_t *s, size_t n, uint_t q) {
+  for (size_t j = 0; j < n; ++j)
+    y[j] = (uint_t)s[j] + (q & -(uint_t)(s[j] < 0));
 }
 
 void poly_rand(const ring_t *const r, poly_t *p, DISTRIBUTION d) {
-  poly_zero(r, p);
+  /* Small samples are drawn into the first residue, then lifted */
+  int_t *s;
 
-  OMP_FOR
-  for (size_t j = 0; j < r->d; ++j) {
-    int_t s = sample(d);
+  if (poly_alloc(r, p))
+    return;
+
+  if (d == UNIFORM) {
+    OMP_FOR
     for (size_t i = 0; i < r->n; ++i)
-      p->b[(i << r->lgd) + j] = s % r->m[i];
+      sample_uniform_n(p->b + (i << r->lgd), r->d, r->m[i]);
+    return;
   }
+
+  s = (int_t *)p->b;
+  if (d == TERNARY)
+    sample_ternary_n(s, r->d);
+  else if (d == ERR_CDT)
+    sample_cdt_n(s, r->d);
+  else
+    sample_err_n(s, r->d);
+
+  OMP_FOR
+  for (size_t i = 1; i < r->n; ++i)
+    poly_lift(p->b + (i << r->lgd), s, r->d, r->m[i]);
+  poly_lift(p->b, s, r->d, r->m[0]);
+}
+
+int poly_expand(const ring_t *const r, poly_t *p,
+                const unsigned char *const seed, uint32_t idx) {
+  int err;
+
+  if ((err = poly_alloc(r, p)))
+    return err;
+
+  OMP_FOR
+  for (size_t i = 0; i < r->n; ++i) {
+    /* Largest multiple of q below 2^64, draws above it are rejected */
+    const uint_t q = r->m[i], lim = ((uint_dt)1 << 64) / q * q;
+    uint8_t key[POLY_SEED_BYTES], buf[CHACHA20_BLOCKBYTES << 3];
+    uint32_t st[16];
+    uint_t *y = p->b + (i << r->lgd);
+
+    memcpy(key, seed, POLY_SEED_BYTES);
+    chacha_init(st, key);
+    /* One stream per residue and polynomial */
+    st[14] = i;
+    st[15] = idx;
+
+    for (size_t j = 0, k = sizeof buf; j < r->d; k += 8) {
+      uint_t v;
+      if (k == sizeof buf) {
+        chacha_blocks(st, buf, sizeof buf / CHACHA20_BLOCKBYTES);
+        k = 0;
+      }
+      v = U8TO32_LITTLE(buf + k) | (uint_t)U8TO32_LITTLE(buf + k + 4) << 32;
+      if (v < lim)
+        y[j++] = v % q;
+    }
+  }
+
+  p->is_ntt = 1;
+  return 0;
+}
+
+void poly_rng_init(poly_rng_t *g, const unsigned char *const seed) {
+  if (seed)
+    memcpy(g->seed, seed, POLY_SEED_BYTES);
+  else
+    rng(g->seed, POLY_SEED_BYTES);
+  g->nonce = 0;
+}
+
+void poly_rng_bytes(poly_rng_t *g, unsigned char *buf, size_t len) {
+  uint64_t w[(POLY_SEED_BYTES + 7) / 8];
+  uint32_t nonce;
+
+  if (!g) {
+    rng(buf, len);
+    return;
+  }
+
+  nonce = __atomic_fetch_add(&g->nonce, 1, __ATOMIC_RELAXED);
+  for (uint64_t pos = 0; len; pos += sizeof w / 8) {
+    const size_t n = len < sizeof w ? len : sizeof w;
+    rng_stream_u64(g->seed, 0, nonce, pos, w, sizeof w / 8);
+    memcpy(buf, w, n);
+    buf += n;
+    len -= n;
+  }
+}
+
+void poly_rand_rng(const ring_t *const r, poly_t *p, DISTRIBUTION d,
+                   poly_rng_t *g) {
+  /* Coefficients per task, every task seeks to its own words */
+  const size_t chunk = r->d < RAND_CHUNK ? r->d : RAND_CHUNK;
+  const size_t tasks = r->d / chunk;
+  uint32_t nonce;
+  int_t *s;
+
+  if (!g) {
+    poly_rand(r, p, d);
+    return;
+  }
+  if (poly_alloc(r, p))
+    return;
+  nonce = __atomic_fetch_add(&g->nonce, 1, __ATOMIC_RELAXED);
+
+  if (d == UNIFORM) {
+    OMP_FOR
+    for (size_t c = 0; c < r->n * tasks; ++c) {
+      /* floor(v q / 2^128) of a 128 bit word v */
+      const size_t i = c / tasks, lo = c % tasks * chunk;
+      const uint_t q = r->m[i];
+      uint_t *y = p->b + (i << r->lgd) + lo;
+      uint64_t w[RAND_CHUNK << 1];
+
+      rng_stream_u64(g->seed, i, nonce, lo << 1, w, chunk << 1);
+      for (size_t j = 0; j < chunk; ++j) {
+        uint_dt v = ((uint_dt)w[j << 1 | 1] * q) >> 64;
+        y[j] = ((uint_dt)w[j << 1] * q + v) >> 64;
+      }
+    }
+    return;
+  }
+
+  s = (int_t *)p->b;
+  OMP_FOR
+  for (size_t c = 0; c < tasks; ++c) {
+    uint64_t *w = (uint64_t *)s + c * chunk;
+
+    rng_stream_u64(g->seed, 0, nonce, c * chunk, w, chunk);
+    for (size_t j = 0; j < chunk; ++j)
+      w[j] = d == TERNARY ? (int_t)(((uint_dt)w[j] * 3) >> 64) - 1
+                          : sample_cdt(w[j]);
+  }
+
+  OMP_FOR
+  for (size_t i = 1; i < r->n; ++i)
+    poly_lift(p->b + (i << r->lgd), s, r->d, r->m[i]);
+  poly_lift(p->b, s, r->d, r->m[0]);
 }
 
 void poly_cmul(poly_t *c, const poly_t *const a, int_t b) {
   ring_t *r = c->r;
 
   OMP_FOR
-  for (size_t i = 0; i < r->n; ++i) {
+  for (size_t i = 0; i < a->n; ++i) {
+    const uint_t q = r->m[i], w = modint(b, q), wp = shoup(w, q);
+    const uint_t *x = a->b + (i << r->lgd);
+    uint_t *y = c->b + (i << r->lgd);
+    for (size_t j = 0; j < r->d; ++j) {
+      uint_t v = mulmod_shoup_lazy(x[j], w, wp, q);
+      y[j] = const_time_select64(v >= q, v - q, v);
+    }
+  }
+
+  c->is_ntt = a->is_ntt;
+  c->n = a->n;
+}
+
+void poly_cmul_rns(poly_t *c, const poly_t *const a, const uint_t *const b) {
+  ring_t *r = c->r;
+
+  OMP_FOR
+  for (size_t i = 0; i < a->n; ++i) {
+    const uint_t q = r->m[i], w = b[i], wp = shoup(w, q);
+    const uint_t *x = a->b + (i << r->lgd);
+    uint_t *y = c->b + (i << r->lgd);
     for (size_t j = 0; j < r->d; ++j) {
-      int index = (i << r->lgd) + j;
-      c->b[index] = modmul(a->b[index], b, r->m[i]);
+      uint_t v = mulmod_shoup_lazy(x[j], w, wp, q);
+      y[j] = const_time_select64(v >= q, v - q, v);
     }
   }
 
   c->is_ntt = a->is_ntt;
+  c->n = a->n;
 }
 
 void poly_neg(poly_t *p) {
   ring_t *r = p->r;
 
   OMP_FOR
-  for (size_t i = 0; i < r->n; ++i) {
+  for (size_t i = 0; i < p->n; ++i) {
+    const uint_t q = r->m[i];
+    uint_t *x = p->b + (i << r->lgd);
+    for (size_t j = 0; j < r->d; ++j)
+      x[j] = const_time_select64(x[j] == 0, 0, q - x[j]);
+  }
+}
+
+/*
+ * Slot j of the NTT holds the evaluation at psi^(2 brv(j) + 1), and
+ * p(x^g) there is p evaluated at psi^((2 brv(j) + 1) g).
+ */
+void poly_automorph(poly_t *out, const poly_t *const in, size_t g) {
+  ring_t *r = in->r;
+  const size_t mask = (r->d << 1) - 1, shift = 32 - r->lgd;
+
+  OMP_FOR
+  for (size_t i = 0; i < in->n; ++i) {
+    const uint_t q = r->m[i];
+    const uint_t *x = in->b + (i << r->lgd);
+    uint_t *y = out->b + (i << r->lgd);
+
+    if (in->is_ntt) {
+      for (size_t j = 0; j < r->d; ++j) {
+        size_t e = (((const_time_reverse32(j) >> shift) << 1) + 1) * g & mask;
+        y[j] = x[const_time_reverse32(e >> 1) >> shift];
+      }
+    } else {
+      for (size_t j = 0; j < r->d; ++j) {
+        size_t e = j * g & mask;
+        uint_t v = const_time_select64(x[j] == 0, 0, q - x[j]);
+        y[e & (r->d - 1)] = const_time_select64(e >= r->d, v, x[j]);
+      }
+    }
+  }
+
+  out->is_ntt = in->is_ntt;
+  out->n = in->n;
+}
+
+int poly_rescale(poly_t *p, uint_t t) {
+  ring_t *r = p->r;
+  size_t l;
+  uint_t ql, w, wp, *buf, *y;
+
+  if (p->n < 2)
+    return -EINVAL;
+  if (!(buf = pool_get(r)))
+    return -errno;
+
+  l = p->n - 1;
+  ql = r->m[l];
+  w = modinv(t % ql, ql);
+  wp = shoup(w, ql);
+
+  /* y = [c t^-1]_{q_l}, so that delta = t y = c mod q_l and 0 mod t */
+  y = buf + (l << r->lgd);
+  memcpy(y, p->b + (l << r->lgd), sizeof(uint_t) << r->lgd);
+  if (p->is_ntt)
+    intt_limb(r, y, l);
+  for (size_t j = 0; j < r->d; ++j) {
+    uint_t v = mulmod_shoup_lazy(y[j], w, wp, ql);
+    y[j] = const_time_select64(v >= ql, v - ql, v);
+  }
+
+  OMP_FOR
+  for (size_t i = 0; i < l; ++i) {
+    const uint_t q = r->m[i], mu = r->barrett[i], tq = t % q;
+    const uint_t qinv = modinv(ql % q, q), qinvp = shoup(qinv, q);
+    uint_t *delta = buf + (i << r->lgd), *x = p->b + (i << r->lgd);
+
+    /* Centered lift of y, so that |delta| <= t q_l / 2 */
     for (size_t j = 0; j < r->d; ++j) {
-      int index = (i << r->lgd) + j;
-      p->b[index] = modsub(r->m[i], p->b[index], r->m[i]);
+      int_t v = const_time_select64(y[j] > (ql >> 1), y[j] - ql, y[j]);
+      delta[j] = modmul_barrett(modint(v, q), tq, q, mu);
+    }
+    if (p->is_ntt)
+      ntt_limb(r, delta, i);
+
+    for (size_t j = 0; j < r->d; ++j) {
+      uint_t v = modsub_ct(x[j], delta[j], q);
+      v = mulmod_shoup_lazy(v, qinv, qinvp, q);
+      x[j] = const_time_select64(v >= q, v - q, v);
     }
   }
+
+  p->n = l;
+  pool_put(r, buf);
+  return 0;
 }
 
 inline void poly_add(poly_t *c, const poly_t *const a, const poly_t *const b) {
-  POLY_BINOP(c, a, b, modadd);
+  POLY_BINOP(c, a, b, add_op);
 }
 
 inline void poly_sub(poly_t *c, const poly_t *const a, const poly_t *const b) {
-  POLY_BINOP(c, a, b, modsub);
+  POLY_BINOP(c, a, b, sub_op);
 }
 
 inline void poly_mul(poly_t *c, const poly_t *const a, const poly_t *const b) {
-  POLY_BINOP(c, a, b, modmul);
+  POLY_BINOP(c, a, b, mul_op);
+}
+
+void poly_fma(poly_t *c, const poly_t *const a, const poly_t *const b) {
+  POLY_TERNOP(c, a, b, c, mul_add_op);
+}
+
+void poly_mul_add(poly_t *d, const poly_t *const a, const poly_t *const b,
+                  const poly_t *const c) {
+  POLY_TERNOP(d, a, b, c, mul_add_op);
+}
+
+void poly_mul_sub(poly_t *d, const poly_t *const a, const poly_t *const b,
+                  const poly_t *const c) {
+  POLY_TERNOP(d, a, b, c, mul_sub_op);
+}
+
+void poly_tensor(poly_t *c, const poly_t *const x, const poly_t *const y) {
+  ring_t *r = c->r;
+  size_t n = x[0].n < x[1].n ? x[0].n : x[1].n;
+  n = n < y[0].n ? n : y[0].n;
+  n = n < y[1].n ? n : y[1].n;
+
+  OMP_FOR
+  for (size_t i = 0; i < n; ++i) {
+    const uint_t q = r->m[i], mu = r->barrett[i];
+    const size_t off = i << r->lgd;
+    const uint_t *x0 = x[0].b + off, *x1 = x[1].b + off;
+    const uint_t *y0 = y[0].b + off, *y1 = y[1].b + off;
+    uint_t *c0 = c[0].b + off, *c1 = c[1].b + off, *c2 = c[2].b + off;
+
+    for (size_t j = 0; j < r->d; ++j) {
+      uint_t lo = modmul_barrett(x0[j], y0[j], q, mu);
+      uint_t hi = modmul_barrett(x1[j], y1[j], q, mu);
+      uint_t mid = modmul_barrett(modadd_ct(x0[j], x1[j], q),
+                                  modadd_ct(y0[j], y1[j], q), q, mu);
+      c0[j] = lo;
+      c1[j] = modsub_ct(modsub_ct(mid, lo, q), hi, q);
+      c2[j] = hi;
+    }
+  }
+
+  c[0].is_ntt = c[1].is_ntt = c[2].is_ntt =
+      x[0].is_ntt | x[1].is_ntt | y[0].is_ntt | y[1].is_ntt;
+  c[0].n = c[1].n = c[2].n = n;
+}
+
+void poly_dot(poly_t *out, const poly_t *const *a, const poly_t *const *b,
+              size_t k) {
+  ring_t *r = out->r;
+  size_t n = r->n;
+  int is_ntt = 0;
+
+  for (size_t l = 0; l < k; ++l) {
+    n = a[l]->n < n ? a[l]->n : n;
+    n = b[l]->n < n ? b[l]->n : n;
+  }
+
+  OMP_FOR
+  for (size_t i = 0; i < n; ++i) {
+    const uint_t q = r->m[i], r64 = (-q) % q, r64p = shoup(r64, q);
+    const uint_t one = shoup(1, q);
+    /* Products are below 2^2L, so this many fit in 128 bits with a residue */
+    const unsigned room = 128 - (bitlen(q) << 1);
+    const size_t chunk = room >= 64 ? SIZE_MAX : ((size_t)1 << room) - 1;
+    const size_t off = i << r->lgd;
+
+    for (size_t j = 0; j < r->d; ++j) {
+      uint_dt acc = 0;
+      for (size_t l = 0, c = 0; l < k; ++l) {
+        if (++c > chunk) {
+          acc = modred_wide(acc, q, r64, r64p, one);
+          c = 1;
+        }
+        acc += (uint_dt)a[l]->b[off + j] * b[l]->b[off + j];
+      }
+      out->b[off + j] = modred_wide(acc, q, r64, r64p, one);
+    }
+  }
+
+  for (size_t l = 0; l < k; ++l)
+    is_ntt |= a[l]->is_ntt | b[l]->is_ntt;
+  out->is_ntt = is_ntt;
+  out->n = n;
 }
 
 void poly_encode(const ring_t *const r, const uint_t *const x, poly_t *p) {
-  poly_zero(r, p);
+  poly_alloc(r, p);
 
   OMP_FOR
   for (size_t i = 0; i < r->n; ++i) {
+    uint_t *y = p->b + (i << r->lgd);
     for (size_t j = 0; j < r->d; ++j)
-      p->b[(i << r->lgd) + j] = x[j] % r->m[i];
+      y[j] = x[j] % r->m[i];
+    ntt_limb(r, y, i);
   }
 
-  poly_ntt(p);
+  p->is_ntt = 1;
 }
 
-void poly_decode(uint_t *out, const poly_t *const p, uint_t mod) {
+void poly_encode_mod(const ring_t *const r, const uint_t *const x, uint_t t,
+                     poly_t *p) {
+  poly_alloc(r, p);
+
+  OMP_FOR
+  for (size_t i = 0; i < r->n; ++i) {
+    uint_t *y = p->b + (i << r->lgd);
+    for (size_t j = 0; j < r->d; ++j) {
+      uint_t v = x[j] % t;
+      y[j] = modint(const_time_select64(v > (t >> 1), v - t, v), r->m[i]);
+    }
+    ntt_limb(r, y, i);
+  }
+
+  p->is_ntt = 1;
+}
+
+/*
+ * With y_j = [c_j (M / m_j)^-1]_{m_j}, the centered lift of c is
+ * sum_j y_j (M / m_j) - v M with v = round(sum_j y_j / m_j). Reducing
+ * that identity mod t needs no multiprecision arithmetic, v is computed
+ * in double precision.
+ */
+int poly_decode(uint_t *out, const poly_t *const p, uint_t t) {
+  const ring_t *r = p->r;
+  const size_t n = p->n;
+  const size_t blk = r->d < DECODE_BLOCK ? r->d : DECODE_BLOCK;
+  uint_t *w, *wp, *mt, *mtp, Mt = 1 % t, Mtp;
+  double *f;
+
+  if (!(w = malloc(sizeof(uint_t) * n * 4 + sizeof(double) * n)))
+    return -errno;
+  wp = w + n;
+  mt = w + 2 * n;
+  mtp = w + 3 * n;
+  f = (double *)(w + 4 * n);
+
+  /* [(M / m_j)^-1]_{m_j} and [M / m_j]_t over the active limbs */
+  for (size_t j = 0; j < n; ++j) {
+    uint_t v = 1;
+    mt[j] = 1 % t;
+    for (size_t l = 0; l < n; ++l) {
+      if (l == j)
+        continue;
+      v = modmul(v, r->m[l], r->m[j]);
+      mt[j] = modmul(mt[j], r->m[l] % t, t);
+    }
+    w[j] = modinv(v, r->m[j]);
+    wp[j] = shoup(w[j], r->m[j]);
+    mtp[j] = shoup(mt[j], t);
+    f[j] = 1.0 / (double)r->m[j];
+    Mt = modmul(Mt, r->m[j] % t, t);
+  }
+  Mtp = shoup(Mt, t);
+
+  OMP_FOR
+  for (size_t i = 0; i < r->d; i += blk) {
+    uint_t acc[DECODE_BLOCK] = {0};
+    double v[DECODE_BLOCK] = {0};
+
+    for (size_t j = 0; j < n; ++j) {
+      const uint_t q = r->m[j], *c = p->b + (j << r->lgd) + i;
+      for (size_t k = 0; k < blk; ++k) {
+        uint_t y = mulmod_shoup_lazy(c[k], w[j], wp[j], q);
+        uint_t z;
+        y = const_time_select64(y >= q, y - q, y);
+        v[k] += (double)y * f[j];
+        z = mulmod_shoup_lazy(y, mt[j], mtp[j], t);
+        z = const_time_select64(z >= t, z - t, z);
+        acc[k] = modadd_ct(acc[k], z, t);
+      }
+    }
+
+    for (size_t k = 0; k < blk; ++k) {
+      uint_t z = mulmod_shoup_lazy((uint_t)(v[k] + 0.5), Mt, Mtp, t);
+      z = const_time_select64(z >= t, z - t, z);
+      out[i + k] = modsub_ct(acc[k], z, t);
+    }
+  }
+
+  free(w);
+  return 0;
+}
+
+void poly_decode_mp(uint_t *out, const poly_t *const p, uint_t mod) {
   ring_t *r = p->r;
+  const size_t n = p->n;
+  mpz_t Ml, Ml_half, *ms = r->ms;
+  mpz_ptr M = r->M, M_half = r->M_half;
+  uint_t *invms = r->invms;
+
+  /* CRT constants of the active limbs */
+  if (n < r->n) {
+    ms = malloc(sizeof(mpz_t) * n);
+    invms = malloc(sizeof(uint_t) * n);
+    if (!ms || !invms)
+      goto FREE_LEVEL;
+
+    mpz_init_set_ui(Ml, 1);
+    for (size_t j = 0; j < n; ++j)
+      mpz_mul_ui(Ml, Ml, r->m[j]);
+    mpz_init(Ml_half);
+    mpz_cdiv_q_ui(Ml_half, Ml, 2);
+    M = Ml, M_half = Ml_half;
+
+    for (size_t j = 0; j < n; ++j) {
+      mpz_init(ms[j]);
+      mpz_divexact_ui(ms[j], M, r->m[j]);
+      invms[j] = modinv(mpz_fdiv_ui(ms[j], r->m[j]), r->m[j]);
+    }
+  }
 
   OMP_FOR
   for (size_t i = 0; i < r->d; ++i) {
@@ -128,31 +638,44 @@ void poly_decode(uint_t *out, const poly_t *const p, uint_t mod) {
     mpz_init(x);
     mpz_init(v);
 
-    for (size_t j = 0; j < r->n; ++j) {
-      mpz_mul_ui(v, r->ms[j], r->invms[j]);
+    for (size_t j = 0; j < n; ++j) {
+      mpz_mul_ui(v, ms[j], invms[j]);
       mpz_mul_ui(v, v, p->b[(j << r->lgd) + i]);
       mpz_add(x, x, v);
     }
-    mpz_mod(x, x, r->M);
-    if (mpz_cmp(x, r->M_half) > 0)
-      mpz_sub(x, x, r->M);
+    mpz_mod(x, x, M);
+    if (mpz_cmp(x, M_half) > 0)
+      mpz_sub(x, x, M);
     out[i] = mpz_fdiv_ui(x, mod);
 
     mpz_clear(v);
     mpz_clear(x);
   }
+
+  if (n < r->n) {
+    for (size_t j = 0; j < n; ++j)
+      mpz_clear(ms[j]);
+    mpz_clear(Ml);
+    mpz_clear(Ml_half);
+  }
+
+FREE_LEVEL:
+  if (n < r->n) {
+    free(invms);
+    free(ms);
+  }
 }
 
 void poly_serialize(unsigned char *out, const poly_t *const p) {
   ring_t *r = p->r;
-  const int len = r->d * r->n * sizeof(int_t);
+  const int len = r->d * p->n * sizeof(int_t);
   for (int i = 0; i < len; ++i)
     out[i] = ((unsigned char *)p->b)[i];
 }
 
 void poly_deserialize(poly_t *p, const unsigned char *const buf) {
   ring_t *r = p->r;
-  const int len = r->d * r->n * sizeof(int_t);
+  const int len = r->d * p->n * sizeof(int_t);
   for (int i = 0; i < len; ++i)
     ((unsigned char *)p->b)[i] = buf[i];
 }
@@ -160,14 +683,18 @@ void poly_deserialize(poly_t *p, const unsigned char *const buf) {
 int poly_cmp(const poly_t *const a, const poly_t *const b) {
   int res = 0;
   ring_t *r = a->r;
-  for (size_t i = 0; i < r->d * r->n; ++i)
+  for (size_t i = 0; i < r->d * a->n && a->n == b->n; ++i)
     res |= (a->b[i] - b->b[i]);
-  return !res;
+  return !res && a->n == b->n;
 }
 
 void poly_free(poly_t *r) {
-  free(r->b);
+  if (r->r)
+    pool_put(r->r, r->b);
+  else
+    free(r->b);
   r->b = NULL;
   r->r = NULL;
+  r->n = 0;
   r->is_ntt = 0;
 }
@@ -0,0 +1,133 @@
+// libfhe
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// This file implements the per-ring coefficient buffer pool.
+///
+//===----------------------------------------------------------------------===//
+
+#include <errno.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+
+#include "fhe_ring.h"
+#include "pool.h"
+
+#define POOL_ALIGN 64
+
+struct ring_pool_t {
+  atomic_flag lock; ///< Guards every field below
+  size_t cap;       ///< Maximum number of cached buffers
+  size_t len;       ///< Number of cached buffers
+  size_t hits;      ///< Requests served from the cache
+  size_t misses;    ///< Requests served from the heap
+  uint_t **cache;   ///< Cached buffers
+};
+
+static inline void pool_lock(struct ring_pool_t *p) {
+  while (atomic_flag_test_and_set_explicit(&p->lock, memory_order_acquire))
+    ;
+}
+
+static inline void pool_unlock(struct ring_pool_t *p) {
+  atomic_flag_clear_explicit(&p->lock, memory_order_release);
+}
+
+/* Buffer size in bytes, rounded up to the alignment */
+static inline size_t pool_size(const ring_t *const r) {
+  size_t size = (sizeof(uint_t) * r->n) << r->lgd;
+  return (size + POOL_ALIGN - 1) & ~(size_t)(POOL_ALIGN - 1);
+}
+
+int ring_pool_init(ring_t *r, size_t cap) {
+  struct ring_pool_t *p;
+
+  if (r->pool)
+    return -EEXIST;
+
+  if (!(p = calloc(1, sizeof(struct ring_pool_t))))
+    return -errno;
+
+  if (!(p->cache = calloc(cap ? cap : 1, sizeof(uint_t *)))) {
+    free(p);
+    return -errno;
+  }
+
+  atomic_flag_clear(&p->lock);
+  p->cap = cap;
+  r->pool = p;
+  return 0;
+}
+
+void ring_pool_stats(const ring_t *const r, ring_pool_stats_t *st) {
+  struct ring_pool_t *p = r->pool;
+
+  st->hits = st->misses = st->cached = 0;
+  if (p) {
+    pool_lock(p);
+    st->hits = p->hits;
+    st->misses = p->misses;
+    st->cached = p->len;
+    pool_unlock(p);
+  }
+}
+
+uint_t *pool_get(const ring_t *const r) {
+  struct ring_pool_t *p = r->pool;
+  uint_t *b = NULL;
+
+  if (p) {
+    pool_lock(p);
+    if (p->len) {
+      b = p->cache[--p->len];
+      p->hits++;
+    } else {
+      p->misses++;
+    }
+    pool_unlock(p);
+  }
+
+  if (!b)
+    b = aligned_alloc(POOL_ALIGN, pool_size(r));
+  return b;
+}
+
+void pool_put(const ring_t *const r, uint_t *b) {
+  struct ring_pool_t *p = r->pool;
+
+  if (b && p) {
+    pool_lock(p);
+    if (p->len < p->cap) {
+      p->cache[p->len++] = b;
+      b = NULL;
+    }
+    pool_unlock(p);
+  }
+  free(b);
+}
+
+void pool_free(ring_t *r) {
+  struct ring_pool_t *p = r->pool;
+
+  if (p) {
+    for (size_t i = 0; i < p->len; ++i)
+      free(p->cache[i]);
+    free(p->cache);
+    free(p);
+    r->pool = NULL;
+  }
+}
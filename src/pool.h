@@ -0,0 +1,55 @@
+// libfhe
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// This file contains the declaration of the per-ring coefficient buffer
+/// pool. Every polynomial of a ring holds exactly n * d coefficients, so
+/// released buffers can be handed back out without touching the heap.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef POOL_H
+#define POOL_H
+
+#include "fhe_config.h"
+#include "fhe_ring.h"
+
+///
+/// \brief Get an uninitialized buffer of n * d coefficients
+/// Falls back to the heap when the ring has no pool or the pool is empty.
+///
+/// \param r Polynomial ring
+///
+uint_t *pool_get(const ring_t *const r);
+
+///
+/// \brief Release a buffer obtained with pool_get
+/// The buffer is cached if the pool has room and freed otherwise.
+///
+/// \param r Polynomial ring
+/// \param b Coefficient buffer, may be NULL
+///
+void pool_put(const ring_t *const r, uint_t *b);
+
+///
+/// \brief Free all cached buffers and the pool itself
+///
+/// \param r Polynomial ring
+///
+void pool_free(ring_t *r);
+
+#endif /* POOL_H */
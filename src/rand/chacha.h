@@ -19,13 +19,24 @@
 /// This file is based on chacha-merged.c version 20080118
 /// D. J. Bernstein Public domain.
 ///
+/// chacha_blocks produces whole blocks, eight at a time with AVX2 when
+/// the CPU supports it. Each AVX2 lane runs the rounds of one block, the
+/// lanes are transposed back into consecutive blocks before the store.
+///
 //===----------------------------------------------------------------------===//
 
 #ifndef RAND_CHACHA
 #define RAND_CHACHA
 
+#include <stddef.h>
 #include <stdint.h>
 
+#include "utils/cpu.h"
+
+#ifdef FHE_X86_64
+#include <immintrin.h>
+#endif
+
 #define CHACHA20_KEYBYTES 32
 #define CHACHA20_BLOCKBYTES 64
 
@@ -195,4 +206,94 @@ static void chacha_keystream_bytes(uint32_t st[16], uint8_t *c,
   }
 }
 
+#ifdef FHE_X86_64
+
+#define CHACHA_LANES 8
+
+#define ROTATE8(v, c)                                                          \
+  _mm256_or_si256(_mm256_slli_epi32(v, c), _mm256_srli_epi32(v, 32 - (c)))
+
+#define QUARTERROUND8(a, b, c, d)                                              \
+  a = _mm256_add_epi32(a, b);                                                  \
+  d = ROTATE8(_mm256_xor_si256(d, a), 16);                                     \
+  c = _mm256_add_epi32(c, d);                                                  \
+  b = ROTATE8(_mm256_xor_si256(b, c), 12);                                     \
+  a = _mm256_add_epi32(a, b);                                                  \
+  d = ROTATE8(_mm256_xor_si256(d, a), 8);                                      \
+  c = _mm256_add_epi32(c, d);                                                  \
+  b = ROTATE8(_mm256_xor_si256(b, c), 7);
+
+/* Rows w[0..7] of 8 lanes become lane k of every row at out + 64 k */
+static inline TARGET_AVX2 void chacha_store8(const __m256i *w, uint8_t *out) {
+  __m256i t[8], u[8];
+
+  for (int i = 0; i < 8; i += 2) {
+    t[i] = _mm256_unpacklo_epi32(w[i], w[i + 1]);
+    t[i + 1] = _mm256_unpackhi_epi32(w[i], w[i + 1]);
+  }
+  for (int i = 0; i < 8; i += 4) {
+    u[i] = _mm256_unpacklo_epi64(t[i], t[i + 2]);
+    u[i + 1] = _mm256_unpackhi_epi64(t[i], t[i + 2]);
+    u[i + 2] = _mm256_unpacklo_epi64(t[i + 1], t[i + 3]);
+    u[i + 3] = _mm256_unpackhi_epi64(t[i + 1], t[i + 3]);
+  }
+  for (int k = 0; k < 4; ++k) {
+    _mm256_storeu_si256((__m256i *)(out + 64 * k),
+                        _mm256_permute2x128_si256(u[k], u[k + 4], 0x20));
+    _mm256_storeu_si256((__m256i *)(out + 64 * (k + 4)),
+                        _mm256_permute2x128_si256(u[k], u[k + 4], 0x31));
+  }
+}
+
+/* Eight consecutive blocks, the counter lives in st[12] and st[13] */
+static inline TARGET_AVX2 void chacha_blocks8(uint32_t st[16], uint8_t *out) {
+  const uint64_t ctr = st[12] | (uint64_t)st[13] << 32;
+  __m256i x[16], j[16];
+
+  for (int i = 0; i < 16; ++i)
+    j[i] = _mm256_set1_epi32(st[i]);
+  j[12] = _mm256_setr_epi32(ctr, ctr + 1, ctr + 2, ctr + 3, ctr + 4, ctr + 5,
+                            ctr + 6, ctr + 7);
+  j[13] = _mm256_setr_epi32((ctr + 0) >> 32, (ctr + 1) >> 32, (ctr + 2) >> 32,
+                            (ctr + 3) >> 32, (ctr + 4) >> 32, (ctr + 5) >> 32,
+                            (ctr + 6) >> 32, (ctr + 7) >> 32);
+  for (int i = 0; i < 16; ++i)
+    x[i] = j[i];
+
+  for (int i = 20; i > 0; i -= 2) {
+    QUARTERROUND8(x[0], x[4], x[8], x[12])
+    QUARTERROUND8(x[1], x[5], x[9], x[13])
+    QUARTERROUND8(x[2], x[6], x[10], x[14])
+    QUARTERROUND8(x[3], x[7], x[11], x[15])
+    QUARTERROUND8(x[0], x[5], x[10], x[15])
+    QUARTERROUND8(x[1], x[6], x[11], x[12])
+    QUARTERROUND8(x[2], x[7], x[8], x[13])
+    QUARTERROUND8(x[3], x[4], x[9], x[14])
+  }
+
+  for (int i = 0; i < 16; ++i)
+    x[i] = _mm256_add_epi32(x[i], j[i]);
+  chacha_store8(x, out);
+  chacha_store8(x + 8, out + 32);
+
+  st[12] = (uint32_t)(ctr + CHACHA_LANES);
+  st[13] = (uint32_t)((ctr + CHACHA_LANES) >> 32);
+}
+
+#endif /* FHE_X86_64 */
+
+/* n whole keystream blocks */
+static inline void chacha_blocks(uint32_t st[16], uint8_t *out, size_t n) {
+#ifdef FHE_X86_64
+  if (n >= CHACHA_LANES && cpu_has_avx2()) {
+    for (; n >= CHACHA_LANES; n -= CHACHA_LANES) {
+      chacha_blocks8(st, out);
+      out += CHACHA_LANES * CHACHA20_BLOCKBYTES;
+    }
+  }
+#endif
+  for (; n; --n, out += CHACHA20_BLOCKBYTES)
+    chacha_keystream_bytes(st, out, CHACHA20_BLOCKBYTES);
+}
+
 #endif /* RAND_CHACHA */
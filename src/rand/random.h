@@ -18,6 +18,10 @@
 /// \file
 /// This file implements a thread local psuedorandom generator
 ///
+/// rng_stream_u64 reads keyed streams instead: stream (idx, nonce) of a
+/// key is ChaCha20 with nonce words idx and nonce, and word w of it lies
+/// in block w / 8, so any range is produced without the words before it.
+///
 //===----------------------------------------------------------------------===//
 
 #ifndef RAND_RANDOM_H
@@ -28,6 +32,7 @@
 #include <math.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "chacha.h"
 
@@ -92,29 +97,84 @@ static void rng_init() {
 static void rng_refill() {
   if (__rng.reseed >= RNG_RESEED)
     rng_init();
-  chacha_keystream_bytes(__rng.chacha_state, __rng.b, RNG_BUF_LEN);
+  chacha_blocks(__rng.chacha_state, __rng.b,
+                RNG_BUF_LEN / CHACHA20_BLOCKBYTES);
   __rng.offset = 0;
   __rng.reseed += RNG_BUF_LEN;
 }
 
+/* Whole keystream blocks straight into buf, reseeding as rng_refill does */
+static inline size_t rng_blocks(uint8_t *buf, size_t len) {
+  size_t done = 0;
+  while (len - done >= CHACHA20_BLOCKBYTES) {
+    size_t n = (len - done) / CHACHA20_BLOCKBYTES;
+    if (__rng.reseed >= RNG_RESEED)
+      rng_init();
+    if (n > (RNG_RESEED - __rng.reseed) / CHACHA20_BLOCKBYTES)
+      n = (RNG_RESEED - __rng.reseed) / CHACHA20_BLOCKBYTES;
+    chacha_blocks(__rng.chacha_state, buf + done, n);
+    __rng.reseed += n * CHACHA20_BLOCKBYTES;
+    done += n * CHACHA20_BLOCKBYTES;
+  }
+  return done;
+}
+
 static inline void rng(void *buffer, size_t len) {
   unsigned char *buf = buffer;
   if (!__rng.init)
     rng_init();
-  if (len > (RNG_BUF_LEN >> 1))
-    chacha_keystream_bytes(__rng.chacha_state, buffer, len);
-  else
-    while (len) {
-      if (__rng.offset >= RNG_BUF_LEN)
-        rng_refill();
-      size_t remaining = RNG_BUF_LEN - __rng.offset;
-      size_t nbytes = len < remaining ? len : remaining;
-      for (int i = 0; i < (int)nbytes; ++i)
-        buf[i] = __rng.b[__rng.offset + i];
-      __rng.offset += nbytes;
-      buf += nbytes;
-      len -= nbytes;
-    }
+  if (len > (RNG_BUF_LEN >> 1)) {
+    size_t done = rng_blocks(buf, len);
+    buf += done;
+    len -= done;
+  }
+  while (len) {
+    if (__rng.offset >= RNG_BUF_LEN)
+      rng_refill();
+    size_t remaining = RNG_BUF_LEN - __rng.offset;
+    size_t nbytes = len < remaining ? len : remaining;
+    memcpy(buf, __rng.b + __rng.offset, nbytes);
+    __rng.offset += nbytes;
+    buf += nbytes;
+    len -= nbytes;
+  }
+}
+
+/* count uniform words written straight into buf */
+static inline void rng_fill_u64(uint64_t *buf, size_t count) {
+  rng(buf, count * sizeof(uint64_t));
+}
+
+/* count words from word pos of stream (idx, nonce) of key */
+static inline void rng_stream_u64(const uint8_t *key, uint32_t idx,
+                                  uint32_t nonce, uint64_t pos, uint64_t *buf,
+                                  size_t count) {
+  const size_t words = CHACHA20_BLOCKBYTES / sizeof(uint64_t);
+  uint8_t k[CHACHA20_KEYBYTES], b[CHACHA20_BLOCKBYTES];
+  uint32_t st[16];
+  size_t off = pos % words, n;
+
+  memcpy(k, key, CHACHA20_KEYBYTES);
+  chacha_init(st, k);
+  st[12] = (uint32_t)(pos / words);
+  st[13] = (uint32_t)(pos / words >> 32);
+  st[14] = idx;
+  st[15] = nonce;
+
+  /* Partial first block, whole blocks in place, partial last block */
+  if (off && count) {
+    chacha_blocks(st, b, 1);
+    n = count < words - off ? count : words - off;
+    memcpy(buf, b + off * sizeof(uint64_t), n * sizeof(uint64_t));
+    buf += n;
+    count -= n;
+  }
+  chacha_blocks(st, (uint8_t *)buf, count / words);
+  buf += count / words * words;
+  if (count % words) {
+    chacha_blocks(st, b, 1);
+    memcpy(buf, b, count % words * sizeof(uint64_t));
+  }
 }
 
 static inline uint32_t uniform32() {
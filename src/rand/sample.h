@@ -19,6 +19,11 @@
 /// This file implements discrete gaussian sampling over the integers.
 /// See https://arxiv.org/pdf/1303.6257.pdf for algorithm details.
 ///
+/// sample_cdt_n inverts the cumulative distribution of |x| instead: a
+/// 63 bit uniform r is compared with every table entry, the number of
+/// entries at most r is |x| and one more random bit gives the sign. The
+/// table is exact to 2^-63 and every sample costs the same.
+///
 //===----------------------------------------------------------------------===//
 
 #ifndef RAND_SAMPLE_H
@@ -34,6 +39,24 @@
 #define MU 0
 #define SIGMA 3.19
 
+/*
+ * round(2^63 P(|x| <= k)) for x drawn with weight exp(-x^2 / (2 SIGMA^2)),
+ * up to the first k where it reaches 2^63
+ */
+#define CDT_LEN 29
+static const uint64_t __cdt[CDT_LEN] = {
+    0x1001f9a1b2ca9468ULL, 0x2e7cf3ef07836cb6ULL, 0x48ca7e85d834a57aULL,
+    0x5d5d51778f760881ULL, 0x6bf35598550421b0ULL, 0x7552dc90807bbed6ULL,
+    0x7ac8820561a4c975ULL, 0x7daa6596524b7ffdULL, 0x7f0b8114bba4ecb9ULL,
+    0x7fa4a9fc5ea574e9ULL, 0x7fe0e1077aef391aULL, 0x7ff6563f810f15d0ULL,
+    0x7ffd4490999bc595ULL, 0x7fff4c0804cd386eULL, 0x7fffd5e18e7fda18ULL,
+    0x7ffff709c679c2eeULL, 0x7ffffe445c790f6cULL, 0x7fffffb20f7aa54aULL,
+    0x7ffffff3903d235dULL, 0x7ffffffe32b06d1dULL, 0x7fffffffc35125ccULL,
+    0x7ffffffff8c11765ULL, 0x7fffffffff36fe33ULL, 0x7fffffffffec3bf8ULL,
+    0x7ffffffffffe3c8bULL, 0x7fffffffffffdb75ULL, 0x7ffffffffffffd51ULL,
+    0x7fffffffffffffd2ULL, 0x7ffffffffffffffdULL,
+};
+
 static inline uint8_t bernoulli() { return uniformr() < EXP_MINUS_HALF; }
 
 static inline uint32_t G() {
@@ -77,6 +100,58 @@ static inline int32_t sample_err() {
   }
 }
 
+/* n values uniform mod q, by Lemire's multiply and reject method */
+static inline void sample_uniform_n(uint64_t *y, size_t n, uint64_t q) {
+  const uint64_t lo = (-q) % q;
+
+  rng_fill_u64(y, n);
+  for (size_t j = 0; j < n; ++j) {
+    uint_dt m = (uint_dt)y[j] * q;
+    while ((uint64_t)m < lo)
+      m = (uint_dt)uniform64() * q;
+    y[j] = m >> 64;
+  }
+}
+
+/* n values in {-1, 0, 1}, five per random byte below 3^5 */
+static inline void sample_ternary_n(int64_t *s, size_t n) {
+  uint8_t buf[64];
+
+  for (size_t j = 0; j < n;) {
+    rng(buf, sizeof buf);
+    for (size_t k = 0; k < sizeof buf && j < n; ++k) {
+      uint8_t b = buf[k];
+      if (b >= 243)
+        continue;
+      for (int l = 0; l < 5 && j < n; ++l, b /= 3)
+        s[j++] = (int64_t)(b % 3) - 1;
+    }
+  }
+}
+
+static inline void sample_err_n(int64_t *s, size_t n) {
+  OMP_FOR
+  for (size_t j = 0; j < n; ++j)
+    s[j] = sample_err();
+}
+
+/* Discrete Gaussian value of a uniform word, in constant time */
+static inline int64_t sample_cdt(uint64_t w) {
+  const uint64_t r = w & (UINT64_MAX >> 1), sign = w >> 63;
+  uint64_t z = 0;
+
+  for (size_t k = 0; k < CDT_LEN; ++k)
+    z += (__cdt[k] - r - 1) >> 63;
+  return (int64_t)((z ^ -sign) + sign);
+}
+
+/* n discrete Gaussian values in constant time */
+static inline void sample_cdt_n(int64_t *s, size_t n) {
+  rng_fill_u64((uint64_t *)s, n);
+  for (size_t j = 0; j < n; ++j)
+    s[j] = sample_cdt((uint64_t)s[j]);
+}
+
 static inline int32_t sample(DISTRIBUTION d) {
   switch (d) {
   case UNIFORM:
@@ -85,6 +160,8 @@ static inline int32_t sample(DISTRIBUTION d) {
     return (uniform32() % 3) - 1;
   case ERR:
     return sample_err();
+  case ERR_CDT:
+    return sample_cdt(uniform64());
   };
   return -1;
 }
@@ -19,23 +19,87 @@
 /// This file implements the cyclotomic polynomial ring
 /// \f$R = Z_M[X] / <x^d + 1>\f$ for a generic modulus \f$M\f$.
 ///
+/// A ring file is a 64 byte header followed by the tables of the ring,
+/// each starting on a 64 byte boundary: the residues and their constants,
+/// the words of M, then the four root tables. Words are stored in host
+/// byte order, which the header records, so a loaded file is used in
+/// place through a read only mapping.
+///
 //===----------------------------------------------------------------------===//
 
 #include <assert.h>
 #include <errno.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#define RING_NO_MMAP
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 #include "utils/const_time.h"
 #include "utils/number_theory.h"
 
 #include "fhe_ring.h"
+#include "pool.h"
+
+#define RING_FILE_MAGIC "libfhe.r"
+#define RING_FILE_VERSION 1
+#define RING_FILE_ORDER 0x01020304
+
+/* Offsets in the file of the tables, in this order */
+enum {
+  RF_M,
+  RF_MINV,
+  RF_BARRETT,
+  RF_DINV,
+  RF_DINV_SHOUP,
+  RF_INVMS,
+  RF_BIG_M,
+  RF_ROOTS,
+  RF_ROOTS_SHOUP,
+  RF_IROOTS,
+  RF_IROOTS_SHOUP,
+  RF_TABLES,
+};
 
-#define M32 (1ULL << 32)
+typedef struct ring_file_t {
+  char magic[8];    ///< RING_FILE_MAGIC
+  uint32_t version; ///< RING_FILE_VERSION
+  uint32_t order;   ///< RING_FILE_ORDER as written by the host
+  uint64_t lgd;     ///< log d
+  uint64_t n;       ///< Number of residues
+  uint64_t mwords;  ///< Number of words of M
+  uint64_t size;    ///< Size of the file in bytes
+  uint64_t sum;     ///< Checksum of the tables
+  uint64_t pad;
+} ring_file_t;
+
+_Static_assert(sizeof(ring_file_t) == 64, "ring file header is 64 bytes");
 
 int ring_init(ring_t *r, size_t lgd, size_t lgq, size_t lgm) {
+  return ring_init_congruent(r, lgd, lgq, lgm, 1);
+}
+
+int ring_init_congruent(ring_t *r, size_t lgd, size_t lgq, size_t lgm,
+                        uint_t t) {
+  /* m_i = 1 mod 2d for the negacyclic NTT, and mod t */
+  const uint_t step = (2UL << lgd) / gcd(2UL << lgd, t) * t;
+
+  if (lgm > 60 || step >= (1ULL << lgm))
+    return -EINVAL;
+
   r->lgd = lgd;
   r->d = (1UL << lgd);
   r->n = (lgq / lgm) + 1;
+  r->pool = NULL;
+  r->map = NULL;
+  r->map_len = 0;
 
   r->m = calloc(1, sizeof(int_t) * r->n);
   if (!r->m)
@@ -53,19 +117,35 @@ int ring_init(ring_t *r, size_t lgd, size_t lgq, size_t lgm) {
   if (!r->minv)
     goto FREE_MINV;
 
+  r->barrett = calloc(1, sizeof(int_t) * r->n);
+  if (!r->barrett)
+    goto FREE_BARRETT;
+
   r->dinv = calloc(1, sizeof(int_t) * r->n);
   if (!r->dinv)
     goto FREE_DINV;
 
+  r->dinv_shoup = calloc(1, sizeof(int_t) * r->n);
+  if (!r->dinv_shoup)
+    goto FREE_DINV_SHOUP;
+
   r->roots = calloc(1, sizeof(int_t) * (r->n << lgd));
   if (!r->roots)
     goto FREE_ROOTS;
 
+  r->roots_shoup = calloc(1, sizeof(int_t) * (r->n << lgd));
+  if (!r->roots_shoup)
+    goto FREE_ROOTS_SHOUP;
+
   r->iroots = calloc(1, sizeof(int_t) * (r->n << lgd));
   if (!r->iroots)
     goto FREE_IROOTS;
 
-  gen_primes(lgm, lgd + 1, r->m, r->n);
+  r->iroots_shoup = calloc(1, sizeof(int_t) * (r->n << lgd));
+  if (!r->iroots_shoup)
+    goto FREE_IROOTS_SHOUP;
+
+  gen_primes(lgm, step, r->m, r->n);
 
   OMP_FOR
   for (size_t i = 0; i < r->n; ++i) {
@@ -75,16 +155,16 @@ int ring_init(ring_t *r, size_t lgd, size_t lgq, size_t lgm) {
     assert(modexp(iroot, r->d << 1, r->m[i]) == 1);
 
     r->minv[i] = inv(r->m[i]);
+    r->barrett[i] = barrett(r->m[i]);
     r->dinv[i] = modinv(r->d, r->m[i]);
-    r->dinv[i] = modmul(r->dinv[i], M32, r->m[i]);
-    r->dinv[i] = modmul(r->dinv[i], M32, r->m[i]);
+    r->dinv_shoup[i] = shoup(r->dinv[i], r->m[i]);
 
     for (size_t j = 0, power = 1, ipower = 1; j < r->d; ++j) {
       int index = i * r->d + (const_time_reverse32(j) >> (32 - lgd));
-      r->roots[index] = modmul(power, M32, r->m[i]);
-      r->roots[index] = modmul(r->roots[index], M32, r->m[i]);
-      r->iroots[index] = modmul(ipower, M32, r->m[i]);
-      r->iroots[index] = modmul(r->iroots[index], M32, r->m[i]);
+      r->roots[index] = power;
+      r->roots_shoup[index] = shoup(power, r->m[i]);
+      r->iroots[index] = ipower;
+      r->iroots_shoup[index] = shoup(ipower, r->m[i]);
       power = modmul(power, root, r->m[i]);
       ipower = modmul(ipower, iroot, r->m[i]);
     }
@@ -106,11 +186,19 @@ int ring_init(ring_t *r, size_t lgd, size_t lgq, size_t lgm) {
 
   return 0;
 
+FREE_IROOTS_SHOUP:
+  free(r->iroots);
 FREE_IROOTS:
+  free(r->roots_shoup);
+FREE_ROOTS_SHOUP:
   free(r->roots);
 FREE_ROOTS:
+  free(r->dinv_shoup);
+FREE_DINV_SHOUP:
   free(r->dinv);
 FREE_DINV:
+  free(r->barrett);
+FREE_BARRETT:
   free(r->minv);
 FREE_MINV:
   free(r->invms);
@@ -122,16 +210,250 @@ FREE_M:
   return -errno;
 }
 
+/* Table offsets of a ring file, returns its size */
+static size_t ring_file_layout(size_t lgd, size_t n, size_t mwords,
+                               size_t *off) {
+  size_t size = sizeof(ring_file_t);
+
+  for (size_t k = 0; k < RF_TABLES; ++k) {
+    const size_t words = k < RF_BIG_M ? n : k == RF_BIG_M ? mwords : n << lgd;
+    off[k] = size;
+    size += (words * sizeof(uint_t) + 63) & ~(size_t)63;
+  }
+  return size;
+}
+
+/* Checksum of the tables, the header fields hashed first */
+static uint64_t ring_file_sum(const ring_file_t *const h,
+                              const unsigned char *const buf) {
+  const uint64_t *w = (const uint64_t *)(buf + sizeof(ring_file_t));
+  const size_t len = (h->size - sizeof(ring_file_t)) / sizeof(uint64_t);
+  uint64_t s = 0xcbf29ce484222325ULL;
+
+  s = (s ^ h->lgd) * 0x100000001b3ULL;
+  s = (s ^ h->n) * 0x100000001b3ULL;
+  s = (s ^ h->mwords) * 0x100000001b3ULL;
+  for (size_t i = 0; i < len; ++i)
+    s = (s ^ w[i]) * 0x100000001b3ULL;
+  return s;
+}
+
+int ring_save(const ring_t *const r, const char *path) {
+  const uint_t *const tables[RF_TABLES] = {
+      [RF_M] = r->m,
+      [RF_MINV] = r->minv,
+      [RF_BARRETT] = r->barrett,
+      [RF_DINV] = r->dinv,
+      [RF_DINV_SHOUP] = r->dinv_shoup,
+      [RF_INVMS] = r->invms,
+      [RF_ROOTS] = r->roots,
+      [RF_ROOTS_SHOUP] = r->roots_shoup,
+      [RF_IROOTS] = r->iroots,
+      [RF_IROOTS_SHOUP] = r->iroots_shoup,
+  };
+  size_t off[RF_TABLES], mwords = (mpz_sizeinbase(r->M, 2) + 63) / 64;
+  ring_file_t h = {.magic = RING_FILE_MAGIC};
+  unsigned char *buf;
+  FILE *f;
+  int err = 0;
+
+  h.version = RING_FILE_VERSION;
+  h.order = RING_FILE_ORDER;
+  h.lgd = r->lgd;
+  h.n = r->n;
+  h.mwords = mwords;
+  h.size = ring_file_layout(r->lgd, r->n, mwords, off);
+
+  if (!(buf = calloc(1, h.size)))
+    return -errno;
+  for (size_t k = 0; k < RF_TABLES; ++k)
+    if (tables[k])
+      memcpy(buf + off[k], tables[k],
+             sizeof(uint_t) * (k < RF_BIG_M ? r->n : r->n << r->lgd));
+  mpz_export(buf + off[RF_BIG_M], NULL, -1, sizeof(uint_t), 0, 0, r->M);
+  h.sum = ring_file_sum(&h, buf);
+  memcpy(buf, &h, sizeof h);
+
+  if (!(f = fopen(path, "wb"))) {
+    err = -errno;
+    goto FREE_BUF;
+  }
+  if (fwrite(buf, 1, h.size, f) != h.size)
+    err = -(errno ? errno : EIO);
+  if (fclose(f) && !err)
+    err = -errno;
+
+FREE_BUF:
+  free(buf);
+  return err;
+}
+
+/* Map or read the whole file */
+static int ring_file_map(const char *path, unsigned char **buf, size_t *len) {
+#ifdef RING_NO_MMAP
+  FILE *f;
+  long size;
+  int err = 0;
+
+  if (!(f = fopen(path, "rb")))
+    return -errno;
+  if (fseek(f, 0, SEEK_END) || (size = ftell(f)) < 0 || fseek(f, 0, SEEK_SET))
+    err = -errno;
+  else if (!(*buf = malloc(size ? size : 1)))
+    err = -errno;
+  else if (fread(*buf, 1, size, f) != (size_t)size) {
+    free(*buf);
+    err = -EIO;
+  }
+  fclose(f);
+  *len = err ? 0 : (size_t)size;
+  return err;
+#else
+  struct stat st;
+  void *map;
+  int fd, err = 0;
+
+  if ((fd = open(path, O_RDONLY)) < 0)
+    return -errno;
+  if (fstat(fd, &st))
+    err = -errno;
+  else if ((size_t)st.st_size < sizeof(ring_file_t))
+    err = -EINVAL;
+  else if ((map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0)) ==
+           MAP_FAILED)
+    err = -errno;
+  close(fd);
+
+  if (!err) {
+    *buf = map;
+    *len = st.st_size;
+  }
+  return err;
+#endif
+}
+
+static void ring_file_unmap(void *buf, size_t len) {
+#ifdef RING_NO_MMAP
+  (void)len;
+  free(buf);
+#else
+  munmap(buf, len);
+#endif
+}
+
+/* Header, size, checksum and residue checks of a mapped ring file */
+static int ring_file_check(const unsigned char *const buf, size_t len,
+                           size_t *off) {
+  const ring_file_t *h = (const ring_file_t *)buf;
+  const uint_t *m;
+
+  if (len < sizeof(ring_file_t) || memcmp(h->magic, RING_FILE_MAGIC, 8) ||
+      h->version != RING_FILE_VERSION || h->order != RING_FILE_ORDER)
+    return -EINVAL;
+  if (!h->lgd || h->lgd > 30 || !h->n || h->n > 1024 || !h->mwords ||
+      h->mwords > h->n)
+    return -EINVAL;
+  if (h->size != len || ring_file_layout(h->lgd, h->n, h->mwords, off) != len)
+    return -EINVAL;
+  if (ring_file_sum(h, buf) != h->sum)
+    return -EINVAL;
+
+  /* Distinct NTT friendly residues just above 2^lgm, with lgm <= 60 */
+  m = (const uint_t *)(buf + off[RF_M]);
+  for (size_t i = 0; i < h->n; ++i) {
+    if (m[i] >> 61 || m[i] % (2UL << h->lgd) != 1)
+      return -EINVAL;
+    for (size_t l = 0; l < i; ++l)
+      if (m[l] == m[i])
+        return -EINVAL;
+  }
+  return 0;
+}
+
+int ring_load(ring_t *r, const char *path) {
+  unsigned char *buf = NULL;
+  size_t off[RF_TABLES], len = 0;
+  const ring_file_t *h;
+  int err;
+
+  if ((err = ring_file_map(path, &buf, &len)))
+    return err;
+  if ((err = ring_file_check(buf, len, off)))
+    goto UNMAP;
+
+  h = (const ring_file_t *)buf;
+  r->lgd = h->lgd;
+  r->d = (1UL << h->lgd);
+  r->n = h->n;
+  r->pool = NULL;
+  r->map = buf;
+  r->map_len = len;
+
+  if (!(r->ms = calloc(1, sizeof(mpz_t) * r->n))) {
+    err = -errno;
+    goto UNMAP;
+  }
+
+  /* The tables are used in place, ring_free never writes to them */
+  r->m = (uint_t *)(buf + off[RF_M]);
+  r->minv = (uint_t *)(buf + off[RF_MINV]);
+  r->barrett = (uint_t *)(buf + off[RF_BARRETT]);
+  r->dinv = (uint_t *)(buf + off[RF_DINV]);
+  r->dinv_shoup = (uint_t *)(buf + off[RF_DINV_SHOUP]);
+  r->invms = (uint_t *)(buf + off[RF_INVMS]);
+  r->roots = (uint_t *)(buf + off[RF_ROOTS]);
+  r->roots_shoup = (uint_t *)(buf + off[RF_ROOTS_SHOUP]);
+  r->iroots = (uint_t *)(buf + off[RF_IROOTS]);
+  r->iroots_shoup = (uint_t *)(buf + off[RF_IROOTS_SHOUP]);
+
+  /* M must be the product of the residues */
+  mpz_init(r->M);
+  mpz_init_set_ui(r->M_half, 1);
+  mpz_import(r->M, h->mwords, -1, sizeof(uint_t), 0, 0, buf + off[RF_BIG_M]);
+  for (size_t i = 0; i < r->n; ++i)
+    mpz_mul_ui(r->M_half, r->M_half, r->m[i]);
+  if (mpz_cmp(r->M_half, r->M)) {
+    mpz_clear(r->M);
+    mpz_clear(r->M_half);
+    free(r->ms);
+    err = -EINVAL;
+    goto UNMAP;
+  }
+  mpz_cdiv_q_ui(r->M_half, r->M, 2);
+
+  for (size_t i = 0; i < r->n; ++i) {
+    mpz_init(r->ms[i]);
+    mpz_divexact_ui(r->ms[i], r->M, r->m[i]);
+  }
+
+  return 0;
+
+UNMAP:
+  ring_file_unmap(buf, len);
+  r->map = NULL;
+  return err;
+}
+
 void ring_free(ring_t *r) {
+  pool_free(r);
   mpz_clear(r->M);
   mpz_clear(r->M_half);
   for (size_t i = 0; i < r->n; ++i)
     mpz_clear(r->ms[i]);
+  free(r->ms);
+  if (r->map) {
+    ring_file_unmap(r->map, r->map_len);
+    r->map = NULL;
+    return;
+  }
+  free(r->iroots_shoup);
   free(r->iroots);
+  free(r->roots_shoup);
   free(r->roots);
+  free(r->dinv_shoup);
   free(r->dinv);
+  free(r->barrett);
   free(r->minv);
   free(r->invms);
-  free(r->ms);
   free(r->m);
 }
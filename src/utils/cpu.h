@@ -0,0 +1,55 @@
+// libfhe
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// This file contains runtime CPU feature detection used to dispatch
+/// vectorized kernels
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef UTILS_CPU_H
+#define UTILS_CPU_H
+
+#if (defined(__x86_64__) || defined(_M_X64)) &&                               \
+    (defined(__GNUC__) || defined(__clang__))
+#define FHE_X86_64 1
+#endif
+
+#ifdef FHE_X86_64
+
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#define TARGET_AVX512 __attribute__((target("avx512f,avx512dq")))
+
+static inline int cpu_has_avx2(void) {
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2");
+}
+
+static inline int cpu_has_avx512(void) {
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx512f") &&
+         __builtin_cpu_supports("avx512dq");
+}
+
+#else
+
+static inline int cpu_has_avx2(void) { return 0; }
+static inline int cpu_has_avx512(void) { return 0; }
+
+#endif /* FHE_X86_64 */
+
+#endif /* UTILS_CPU_H */
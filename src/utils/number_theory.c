@@ -63,13 +63,12 @@ int is_prime(uint_t p) {
 }
 
 /* Generates a sequence of l-bit primes of the form
- * p = k * 2^m + 1
+ * p = k * m + 1
  */
 void gen_primes(uint_t l, uint_t m, uint_t *p, unsigned n) {
   static int k = 0;
 
-  m = (1ULL << m);
-  l = (1ULL << l);
+  l = ((1ULL << l) + m - 1) / m * m;
 
   for (unsigned i = 0; i < n; ++i)
     do {
@@ -25,6 +25,7 @@
 #define UTILS_NUMBER_THEORY_H
 
 #include "fhe_config.h"
+#include "utils/const_time.h"
 
 int is_prime(uint_t);
 uint_t find_proot(uint_t, uint_t);
@@ -36,6 +37,15 @@ static inline uint_t modmul(uint_t a, uint_t b, uint_t m) {
   return mul % (uint_dt)(m);
 }
 
+static inline uint_t gcd(uint_t a, uint_t b) {
+  while (b) {
+    uint_t r = a % b;
+    a = b;
+    b = r;
+  }
+  return a;
+}
+
 static inline uint_t modadd(uint_t a, uint_t b, uint_t m) {
   return (a + b) % m;
 }
@@ -46,12 +56,73 @@ static inline uint_t modsub(uint_t a, uint_t b, uint_t m) {
 
 static inline uint_t modinv(uint_t a, uint_t m) { return modexp(a, m - 2, m); }
 
+/* Bit length of a nonzero modulus m */
+static inline unsigned bitlen(uint_t m) { return 64 - __builtin_clzll(m); }
+
+/* floor(2^2L / m) for an L bit modulus m, L <= 62 */
+static inline uint_t barrett(uint_t m) {
+  return ((uint_dt)1 << (bitlen(m) << 1)) / m;
+}
+
+/* z mod m for z < 2^2L, with mu = barrett(m) */
+static inline uint_t modred_barrett(uint_dt z, uint_t m, uint_t mu) {
+  const unsigned l = bitlen(m);
+  uint_t q = ((uint_dt)(uint_t)(z >> (l - 1)) * mu) >> (l + 1);
+  uint_t r = (uint_t)z - q * m;
+  r = const_time_select64(r >= m, r - m, r);
+  return const_time_select64(r >= m, r - m, r);
+}
+
+/* a * b mod m for a, b in [0, m) */
+static inline uint_t modmul_barrett(uint_t a, uint_t b, uint_t m, uint_t mu) {
+  return modred_barrett((uint_dt)a * b, m, mu);
+}
+
+/* a + b mod m for a, b in [0, m) */
+static inline uint_t modadd_ct(uint_t a, uint_t b, uint_t m) {
+  return const_time_select64(a + b >= m, a + b - m, a + b);
+}
+
+/* a - b mod m for a, b in [0, m) */
+static inline uint_t modsub_ct(uint_t a, uint_t b, uint_t m) {
+  return const_time_select64(a < b, a + m - b, a - b);
+}
+
+/* Signed integer a mod m */
+static inline uint_t modint(int_t a, uint_t m) {
+  if (a >= 0)
+    return (uint_t)a % m;
+  return m - 1 - ((uint_t)(-(a + 1)) % m);
+}
+
 static inline uint_t mul64(uint_t a, uint_t b, uint_t *hi) {
   uint_dt res = (uint_dt)a * b;
   *hi = res >> 64;
   return res;
 }
 
+/* floor(w * 2^64 / q), the Shoup companion of a constant w < q */
+static inline uint_t shoup(uint_t w, uint_t q) {
+  return ((uint_dt)w << 64) / q;
+}
+
+/* x * w mod q in [0, 2q) for any x, with wp = shoup(w, q) and q < 2^63 */
+static inline uint_t mulmod_shoup_lazy(uint_t x, uint_t w, uint_t wp,
+                                       uint_t q) {
+  uint_t hi;
+  mul64(x, wp, &hi);
+  return x * w - hi * q;
+}
+
+/* acc mod m for any acc < 2^128, r64 = 2^64 mod m and one = floor(2^64 / m) */
+static inline uint_t modred_wide(uint_dt acc, uint_t m, uint_t r64,
+                                 uint_t r64p, uint_t one) {
+  uint_t r = mulmod_shoup_lazy(acc >> 64, r64, r64p, m) +
+             mulmod_shoup_lazy((uint_t)acc, 1, one, m);
+  r = const_time_select64(r >= (m << 1), r - (m << 1), r);
+  return const_time_select64(r >= m, r - m, r);
+}
+
 static inline uint_t inv(uint_t a) {
   uint_t r = 1;
   for (uint_t m = 2; m; m <<= 1) {
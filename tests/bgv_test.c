@@ -1,14 +1,42 @@
 #include <assert.h>
+#include <errno.h>
+#include <stdint.h>
 #include <string.h>
 
 #include <fhe.h>
 
 #include "params.h"
 
+/* Bit length of the largest centered coefficient of v */
+static size_t noise_bits(const poly_t *const v) {
+  const ring_t *r = v->r;
+  size_t bits = 0;
+  mpz_t x, y;
+
+  mpz_init(x);
+  mpz_init(y);
+  for (size_t j = 0; j < r->d; ++j) {
+    mpz_set_ui(x, 0);
+    for (size_t i = 0; i < r->n; ++i) {
+      mpz_mul_ui(y, r->ms[i], v->b[(i << r->lgd) + j]);
+      mpz_addmul_ui(x, y, r->invms[i]);
+    }
+    mpz_mod(x, x, r->M);
+    if (mpz_cmp(x, r->M_half) > 0)
+      mpz_sub(x, x, r->M);
+    if (mpz_sizeinbase(x, 2) > bits)
+      bits = mpz_sizeinbase(x, 2);
+  }
+  mpz_clear(x);
+  mpz_clear(y);
+  return bits;
+}
+
 int main() {
   bgv_t b;
   bgv_key_t k;
   uint_t x[D] = {1};
+  static uint_t pu[D], pv[D];
   bgv_ct_t cu, cv, cw, cuv, cvu, cvw, cvuw, cuw, cuwv;
   poly_t zero, one, du, dv, u, v, w, uv, uw;
 
@@ -61,7 +89,9 @@ int main() {
     bgv_ct_mul(&cuwv, &k.eval, &cuw, &cv);
     bgv_decrypt(&du, &cvuw, &k.s);
     bgv_decrypt(&dv, &cuwv, &k.s);
-    assert(memcmp(du.b, dv.b, b.r.n) == 0);
+    poly_decode(pu, &du, T);
+    poly_decode(pv, &dv, T);
+    assert(!memcmp(pu, pv, sizeof pu));
 
     bgv_ct_free(&cvu);
     bgv_ct_free(&cvw);
@@ -72,6 +102,113 @@ int main() {
     poly_free(&dv);
   }
 
+  {
+    ring_pool_stats_t st;
+    size_t misses = 0;
+
+    bgv_ct_init(&b.r, &cuv, 2);
+    bgv_ct_init(&b.r, &cvu, 2);
+    poly_zero(&b.r, &du);
+    poly_zero(&b.r, &dv);
+    assert(bgv_ct_add_into(&cuv, &cu, &cu) == 0);
+    assert(bgv_ct_add_into(&cuv, &cuv, &cw) == 0);
+    assert(bgv_ct_sub_into(&cuv, &cuv, &cu) == 0);
+    assert(bgv_ct_mul_into(&cvu, &k.eval, &cuv, &cv) == 0);
+    bgv_ct_mul(&cvw, &k.eval, &cu, &cv);
+    bgv_ct_mul(&cuw, &k.eval, &cw, &cv);
+    bgv_ct_add(&cvuw, &cvw, &cuw);
+    bgv_ct_sub(&cuwv, &cvuw, &cvw);
+    bgv_ct_sub_into(&cuwv, &cuwv, &cuw);
+    assert(bgv_decrypt_into(&du, &cvu, &k.s) == 0);
+    bgv_decrypt_into(&dv, &cvuw, &k.s);
+    poly_decode(pu, &du, T);
+    poly_decode(pv, &dv, T);
+    assert(!memcmp(pu, pv, sizeof pu));
+    bgv_decrypt_into(&dv, &cuwv, &k.s);
+    poly_intt(&zero);
+    assert(poly_cmp(&dv, &zero));
+    bgv_ct_free(&cvw);
+    bgv_ct_init(&b.r, &cvw, 4);
+    assert(bgv_ct_mul_into(&cvw, &k.eval, &cu, &cv) == -EINVAL);
+    assert(bgv_ct_add_into(&cvw, &cu, &cv) == -EINVAL);
+
+    /* Steady state encryption and evaluation draws from the pool only */
+    ring_pool_init(&b.r, 8);
+    for (int i = 0; i < 2; ++i) {
+      assert(bgv_encrypt_into(&b, &cuv, &k.pub, &u) == 0);
+      bgv_ct_mul_into(&cvu, &k.eval, &cuv, &cv);
+      bgv_ct_add_into(&cvu, &cvu, &cw);
+      bgv_decrypt_into(&du, &cvu, &k.s);
+      ring_pool_stats(&b.r, &st);
+      assert(!i || st.misses == misses);
+      misses = st.misses;
+      (void)misses;
+    }
+
+    bgv_ct_free(&cuv);
+    bgv_ct_free(&cvu);
+    bgv_ct_free(&cvw);
+    bgv_ct_free(&cuw);
+    bgv_ct_free(&cvuw);
+    bgv_ct_free(&cuwv);
+    poly_free(&du);
+    poly_free(&dv);
+  }
+
+  {
+    /* <(u, v, w), (v, w, u)> relinearized once */
+    static uint_t eager[D], lazy[D];
+    bgv_ct_t *ct[] = {&cu, &cv, &cw};
+    int err;
+
+    bgv_ct_init(&b.r, &cuv, 3);
+    bgv_ct_init(&b.r, &cvu, 2);
+    poly_zero(&b.r, &du);
+    poly_zero(&b.r, &dv);
+    for (int i = 0; i < 3; ++i) {
+      bgv_ct_mul(&cvw, NULL, ct[i], ct[(i + 1) % 3]);
+      assert(cvw.n == 3);
+      bgv_ct_add_into(&cuv, &cuv, &cvw);
+      bgv_ct_free(&cvw);
+
+      bgv_ct_mul(&cvw, &k.eval, ct[i], ct[(i + 1) % 3]);
+      bgv_ct_add_into(&cvu, &cvu, &cvw);
+      bgv_ct_free(&cvw);
+    }
+    err = bgv_ct_relin(&cuv, &k.eval);
+    assert(!err && cuv.n == 2);
+    err = bgv_ct_relin(&cuv, &k.eval);
+    assert(!err && cuv.n == 2);
+    bgv_decrypt_into(&du, &cuv, &k.s);
+    bgv_decrypt_into(&dv, &cvu, &k.s);
+    poly_decode(lazy, &du, T);
+    poly_decode(eager, &dv, T);
+    assert(!memcmp(lazy, eager, sizeof lazy));
+
+    /* Mixed lengths */
+    bgv_ct_init(&b.r, &cvw, 3);
+    err = bgv_ct_mul_into(&cvw, NULL, &cu, &cv);
+    assert(!err);
+    err = bgv_ct_mul(&cuw, &k.eval, &cvw, &cu);
+    assert(err == -EINVAL);
+    err = bgv_ct_relin(&cuv, NULL) | bgv_ct_mul_into(&cuv, NULL, &cu, &cv);
+    assert(err == -EINVAL);
+    (void)err;
+    bgv_ct_add(&cuw, &cw, &cvw);
+    bgv_ct_sub_into(&cuw, &cuw, &cvw);
+    assert(cuw.n == 3);
+    bgv_decrypt_into(&du, &cuw, &k.s);
+    bgv_decrypt_into(&dv, &cw, &k.s);
+    assert(poly_cmp(&du, &dv));
+
+    bgv_ct_free(&cuv);
+    bgv_ct_free(&cvu);
+    bgv_ct_free(&cvw);
+    bgv_ct_free(&cuw);
+    poly_free(&du);
+    poly_free(&dv);
+  }
+
   bgv_ct_free(&cv);
   bgv_ct_free(&cu);
   bgv_ct_free(&cw);
@@ -87,5 +224,424 @@ int main() {
   bgv_key_free(&k);
   bgv_free(&b);
 
+  {
+    /* Relinearization with two digits and with one limb per digit */
+    static uint_t got[1 << 10], want[1 << 10];
+    const size_t dnum[] = {2, SIZE_MAX};
+
+    for (size_t i = 0; i < sizeof dnum / sizeof *dnum; ++i) {
+      bgv_init_dnum(&b, 10, 400, LGM, T, dnum[i]);
+      bgv_keygen(&b, &k);
+      assert(k.eval.dnum == (dnum[i] < b.r.n ? dnum[i] : b.r.n));
+
+      for (size_t j = 0; j < b.r.d; ++j) {
+        got[j] = (j * 7919) % T;
+        want[j] = (j * j + 3) % T;
+      }
+      poly_encode(&b.r, got, &u);
+      poly_encode(&b.r, want, &v);
+      bgv_encrypt(&b, &cu, &k.pub, &u);
+      bgv_encrypt(&b, &cv, &k.pub, &v);
+      bgv_ct_mul(&cuv, &k.eval, &cu, &cv);
+      bgv_decrypt(&du, &cuv, &k.s);
+      poly_decode(got, &du, T);
+
+      poly_zero(&b.r, &dv);
+      poly_mul(&dv, &u, &v);
+      poly_intt(&dv);
+      poly_decode(want, &dv, T);
+      assert(!memcmp(got, want, sizeof got));
+
+      bgv_ct_free(&cuv);
+      bgv_ct_free(&cu);
+      bgv_ct_free(&cv);
+      poly_free(&du);
+      poly_free(&dv);
+      poly_free(&u);
+      poly_free(&v);
+      bgv_key_free(&k);
+      bgv_free(&b);
+    }
+  }
+
+  {
+    /* Modulus switching keeps the plaintext, relinearization at a level */
+    static uint_t got[1 << 10], want[1 << 10];
+
+    bgv_init(&b, 10, 400, LGM, T);
+    bgv_keygen(&b, &k);
+    for (size_t i = 0; i < b.r.n; ++i)
+      assert(b.r.m[i] % T == 1);
+
+    for (size_t j = 0; j < b.r.d; ++j) {
+      got[j] = (j * 7919) % T;
+      want[j] = (j * j + 3) % T;
+    }
+    poly_encode(&b.r, got, &u);
+    poly_encode(&b.r, want, &v);
+    bgv_encrypt(&b, &cu, &k.pub, &u);
+    bgv_encrypt(&b, &cv, &k.pub, &v);
+    assert(bgv_ct_level(&cu) == b.r.n - 1);
+
+    bgv_ct_modswitch(&b, &cu);
+    bgv_ct_modswitch(&b, &cu);
+    assert(bgv_ct_level(&cu) == b.r.n - 3);
+    poly_zero(&b.r, &du);
+    bgv_decrypt_into(&du, &cu, &k.s);
+    assert(du.n == b.r.n - 2);
+    poly_decode(got, &du, T);
+    poly_clone(&dv, &u);
+    poly_intt(&dv);
+    poly_decode(want, &dv, T);
+    assert(!memcmp(got, want, sizeof got));
+
+    /* Mixed levels add over the common limbs */
+    bgv_ct_add(&cuv, &cu, &cv);
+    assert(bgv_ct_level(&cuv) == b.r.n - 3);
+    bgv_decrypt_into(&du, &cuv, &k.s);
+    poly_decode(got, &du, T);
+    poly_add(&dv, &u, &v);
+    poly_intt(&dv);
+    poly_decode(want, &dv, T);
+    assert(!memcmp(got, want, sizeof got));
+    bgv_ct_free(&cuv);
+
+    /* Digits are truncated to the active limbs */
+    bgv_ct_modswitch(&b, &cv);
+    bgv_ct_modswitch(&b, &cv);
+    assert(bgv_ct_level(&cv) == b.r.n - 3);
+    bgv_ct_mul(&cuv, &k.eval, &cu, &cv);
+    while (bgv_ct_level(&cuv))
+      bgv_ct_modswitch(&b, &cuv);
+    assert(bgv_ct_modswitch(&b, &cuv) == -EINVAL);
+    assert(bgv_ct_size(&cuv) == 2 * b.r.d * 8 + 8);
+
+    bgv_decrypt_into(&du, &cuv, &k.s);
+    poly_decode(got, &du, T);
+    poly_mul(&dv, &u, &v);
+    poly_intt(&dv);
+    poly_decode(want, &dv, T);
+    assert(!memcmp(got, want, sizeof got));
+
+    bgv_ct_free(&cuv);
+    bgv_ct_free(&cu);
+    bgv_ct_free(&cv);
+    poly_free(&du);
+    poly_free(&dv);
+    poly_free(&u);
+    poly_free(&v);
+    bgv_key_free(&k);
+    bgv_free(&b);
+  }
+
+  {
+    /* Rotations, hoisted rotations and rotations below the top level */
+    static uint_t got[1 << 10], want[1 << 10];
+    const long steps[] = {1, -1, 7};
+    size_t g[4];
+    bgv_galois_t gk;
+    bgv_ct_t rot[3];
+
+    bgv_init(&b, 10, 400, LGM, T);
+    bgv_keygen(&b, &k);
+    for (size_t i = 0; i < 3; ++i)
+      g[i] = bgv_galois_elt(&b.r, steps[i]);
+    g[3] = (b.r.d << 1) - 1;
+    bgv_galois_keygen(&b, &gk, &k, g, 4);
+    assert(gk.n == 4);
+    assert(g[0] == 3 && g[1] * 3 % (b.r.d << 1) == 1);
+
+    for (size_t j = 0; j < b.r.d; ++j)
+      got[j] = (j * 7919) % T;
+    poly_encode(&b.r, got, &u);
+    poly_zero(&b.r, &v);
+    poly_zero(&b.r, &du);
+    bgv_encrypt(&b, &cu, &k.pub, &u);
+    bgv_ct_rotate_hoisted(&gk, rot, &cu, steps, 3);
+    for (size_t i = 0; i < 4; ++i) {
+      poly_automorph(&v, &u, g[i]);
+      poly_intt(&v);
+      poly_decode(want, &v, T);
+
+      if (i < 3) {
+        bgv_decrypt_into(&du, rot + i, &k.s);
+        poly_decode(got, &du, T);
+        assert(!memcmp(got, want, sizeof got));
+        bgv_ct_free(rot + i);
+      }
+
+      bgv_encrypt(&b, &cuv, &k.pub, &u);
+      bgv_ct_modswitch(&b, &cuv);
+      bgv_ct_automorph(&gk, &cuv, g[i]);
+      assert(bgv_ct_level(&cuv) == b.r.n - 2);
+      bgv_decrypt_into(&du, &cuv, &k.s);
+      poly_decode(got, &du, T);
+      assert(!memcmp(got, want, sizeof got));
+      bgv_ct_free(&cuv);
+    }
+
+    /* Rotated ciphertexts can be modswitched and rotated again */
+    bgv_encrypt(&b, &cuv, &k.pub, &u);
+    bgv_ct_rotate(&gk, &cuv, 1);
+    bgv_ct_modswitch(&b, &cuv);
+    poly_automorph(&v, &u, g[0]);
+    poly_intt(&v);
+    poly_decode(want, &v, T);
+    bgv_decrypt_into(&du, &cuv, &k.s);
+    poly_decode(got, &du, T);
+    assert(!memcmp(got, want, sizeof got));
+    bgv_ct_rotate(&gk, &cuv, 1);
+    poly_automorph(&v, &u, g[0] * g[0]);
+    poly_intt(&v);
+    poly_decode(want, &v, T);
+    bgv_decrypt_into(&du, &cuv, &k.s);
+    poly_decode(got, &du, T);
+    assert(!memcmp(got, want, sizeof got));
+    bgv_ct_free(&cuv);
+    assert(bgv_ct_rotate(&gk, &cu, 2) == -EINVAL);
+
+    bgv_galois_free(&gk);
+    bgv_ct_free(&cu);
+    poly_free(&du);
+    poly_free(&u);
+    poly_free(&v);
+    bgv_key_free(&k);
+    bgv_free(&b);
+  }
+
+  {
+    /* Plaintext and scalar operations */
+    static uint_t got[1 << 10], want[1 << 10];
+    bgv_pt_t pt;
+
+    bgv_init(&b, 10, 400, LGM, T);
+    bgv_keygen(&b, &k);
+
+    for (size_t j = 0; j < b.r.d; ++j) {
+      got[j] = (j * 7919) % T;
+      want[j] = (T - 1 - j * j) % T;
+    }
+    poly_encode(&b.r, got, &u);
+    bgv_pt_encode(&b, &pt, want);
+    poly_zero(&b.r, &v);
+    poly_zero(&b.r, &du);
+    bgv_encrypt(&b, &cu, &k.pub, &u);
+    bgv_ct_init(&b.r, &cv, 2);
+
+    bgv_ct_mul_plain(&cv, &cu, &pt.p);
+    bgv_ct_add_plain(&cv, &cv, &u);
+    bgv_ct_mul_scalar(&cv, &cv, -3);
+    bgv_decrypt_into(&du, &cv, &k.s);
+    poly_decode(got, &du, T);
+
+    poly_mul_add(&v, &u, &pt.p, &u);
+    poly_cmul(&v, &v, -3);
+    poly_intt(&v);
+    poly_decode(want, &v, T);
+    assert(!memcmp(got, want, sizeof got));
+
+    /* Below the top level, with a plaintext in coefficient form */
+    bgv_ct_modswitch(&b, &cu);
+    poly_intt(&u);
+    bgv_ct_mul_plain(&cu, &cu, &u);
+    bgv_decrypt_into(&du, &cu, &k.s);
+    poly_decode(got, &du, T);
+    poly_ntt(&u);
+    poly_mul(&v, &u, &u);
+    poly_intt(&v);
+    poly_decode(want, &v, T);
+    assert(!memcmp(got, want, sizeof got));
+    assert(bgv_ct_mul_scalar(&cuv, &cu, 2) == -EINVAL);
+
+    bgv_pt_free(&pt);
+    bgv_ct_free(&cu);
+    bgv_ct_free(&cv);
+    poly_free(&du);
+    poly_free(&u);
+    poly_free(&v);
+    bgv_key_free(&k);
+    bgv_free(&b);
+  }
+
+  {
+    /* Slot encoding: products and rotations act slot wise */
+    static uint_t x[1 << 10], y[1 << 10], got[1 << 10];
+    size_t g[2];
+    bgv_batch_t e;
+    bgv_galois_t gk;
+    bgv_pt_t px, py;
+
+    /* 65537 - 1 = 2^16 is not a multiple of 2d */
+    bgv_init(&b, LGD, 100, LGM, T);
+    assert(bgv_batch_init(&b, &e) == -EINVAL);
+    bgv_free(&b);
+
+    bgv_init(&b, 10, 400, LGM, T);
+    bgv_keygen(&b, &k);
+    bgv_batch_init(&b, &e);
+    assert(e.t == T);
+    g[0] = bgv_galois_elt(&b.r, 1);
+    g[1] = (b.r.d << 1) - 1;
+    bgv_galois_keygen(&b, &gk, &k, g, 2);
+
+    for (size_t j = 0; j < b.r.d; ++j) {
+      x[j] = (j * 7919) % T;
+      y[j] = (T - 1 - j * j) % T;
+    }
+    bgv_batch_encode(&b, &e, &px, x);
+    bgv_batch_encode(&b, &e, &py, y);
+    poly_clone(&u, &px.p);
+    poly_intt(&u);
+    bgv_batch_decode(&e, got, &u);
+    assert(!memcmp(got, x, sizeof got));
+    poly_free(&u);
+
+    poly_zero(&b.r, &du);
+    bgv_encrypt(&b, &cu, &k.pub, &px.p);
+    bgv_encrypt(&b, &cv, &k.pub, &py.p);
+    bgv_ct_mul(&cuv, &k.eval, &cu, &cv);
+    bgv_decrypt_into(&du, &cuv, &k.s);
+    bgv_batch_decode(&e, got, &du);
+    for (size_t j = 0; j < b.r.d; ++j)
+      assert(got[j] == x[j] * y[j] % T);
+
+    bgv_ct_mul_plain(&cuv, &cu, &py.p);
+    bgv_ct_add_plain(&cuv, &cuv, &px.p);
+    bgv_decrypt_into(&du, &cuv, &k.s);
+    bgv_batch_decode(&e, got, &du);
+    for (size_t j = 0; j < b.r.d; ++j)
+      assert(got[j] == (x[j] * y[j] + x[j]) % T);
+    bgv_ct_free(&cuv);
+
+    /* Rotation by 1 shifts each row of 512 slots left, conjugation swaps them */
+    bgv_ct_rotate(&gk, &cu, 1);
+    bgv_decrypt_into(&du, &cu, &k.s);
+    bgv_batch_decode(&e, got, &du);
+    for (size_t j = 0; j < b.r.d; ++j)
+      assert(got[j] == x[(j & 512) | ((j + 1) & 511)]);
+    bgv_ct_automorph(&gk, &cv, g[1]);
+    bgv_decrypt_into(&du, &cv, &k.s);
+    bgv_batch_decode(&e, got, &du);
+    for (size_t j = 0; j < b.r.d; ++j)
+      assert(got[j] == y[j ^ 512]);
+
+    bgv_galois_free(&gk);
+    bgv_batch_free(&e);
+    bgv_pt_free(&px);
+    bgv_pt_free(&py);
+    bgv_ct_free(&cu);
+    bgv_ct_free(&cv);
+    poly_free(&du);
+    bgv_key_free(&k);
+    bgv_free(&b);
+  }
+
+  {
+    /* Encryptions completed from precomputed encryptions of zero */
+    static uint_t got[1 << 10], want[1 << 10];
+    bgv_encpool_t pool;
+
+    bgv_init(&b, 10, 400, LGM, T);
+    bgv_keygen(&b, &k);
+    for (size_t j = 0; j < b.r.d; ++j)
+      want[j] = (j * 7919) % T;
+    poly_encode(&b.r, want, &u);
+    poly_zero(&b.r, &du);
+
+    for (int background = 0; background < 2; ++background) {
+      bgv_encpool_init(&b, &pool, &k.pub, 3, background);
+      if (!background) {
+        bgv_encpool_fill(&pool, 5);
+        assert(bgv_encpool_size(&pool) == 3);
+      }
+
+      /* The last encryptions outrun the pool and are computed in place */
+      for (int i = 0; i < 5; ++i) {
+        bgv_encrypt_pooled(&pool, &cu, &u);
+        bgv_decrypt_into(&du, &cu, &k.s);
+        poly_decode(got, &du, T);
+        assert(!memcmp(got, want, sizeof got));
+        bgv_ct_free(&cu);
+      }
+      bgv_encpool_free(&pool);
+    }
+
+    poly_free(&du);
+    poly_free(&u);
+    bgv_key_free(&k);
+    bgv_free(&b);
+  }
+
+  {
+    /* Keys and encryptions are functions of the generator state */
+    const unsigned char seed[POLY_SEED_BYTES] = {1, 2, 3};
+    static uint_t got[1 << 10], want[1 << 10];
+    poly_rng_t g, h;
+    bgv_key_t l;
+
+    bgv_init(&b, 10, 400, LGM, T);
+    poly_rng_init(&g, seed);
+    poly_rng_init(&h, seed);
+    bgv_keygen_rng(&b, &k, &g);
+    bgv_keygen_rng(&b, &l, &h);
+    assert(bgv_key_cmp(&k, &l));
+
+    for (size_t j = 0; j < b.r.d; ++j)
+      want[j] = (j * 31) % T;
+    poly_encode(&b.r, want, &u);
+    bgv_ct_init(&b.r, &cu, 2);
+    bgv_ct_init(&b.r, &cv, 2);
+    bgv_encrypt_into_rng(&b, &cu, &k.pub, &u, &g);
+    bgv_encrypt_into_rng(&b, &cv, &l.pub, &u, &h);
+    for (size_t i = 0; i < 2; ++i)
+      assert(poly_cmp(cu.c + i, cv.c + i));
+
+    bgv_decrypt(&du, &cu, &k.s);
+    poly_decode(got, &du, T);
+    assert(!memcmp(got, want, sizeof got));
+
+    bgv_ct_free(&cu);
+    bgv_ct_free(&cv);
+    poly_free(&du);
+    poly_free(&u);
+    bgv_key_free(&l);
+    bgv_key_free(&k);
+    bgv_free(&b);
+  }
+
+  {
+    /* At the default digits a relinearization costs under one residue */
+    static uint_t want[1 << 12];
+    size_t before, after;
+
+    bgv_init(&b, 12, LGQ, LGM, T);
+    bgv_keygen(&b, &k);
+    assert(k.eval.dnum == b.r.n);
+    for (size_t j = 0; j < b.r.d; ++j)
+      want[j] = (j * 7919) % T;
+    poly_encode(&b.r, want, &u);
+    bgv_encrypt(&b, &cu, &k.pub, &u);
+    bgv_encrypt(&b, &cv, &k.pub, &u);
+    bgv_ct_mul(&cuv, NULL, &cu, &cv);
+
+    poly_zero(&b.r, &du);
+    bgv_decrypt_into(&du, &cuv, &k.s);
+    before = noise_bits(&du);
+    bgv_ct_relin(&cuv, &k.eval);
+    bgv_decrypt_into(&du, &cuv, &k.s);
+    after = noise_bits(&du);
+    assert(after < before + LGM);
+    (void)before;
+    (void)after;
+
+    bgv_ct_free(&cuv);
+    bgv_ct_free(&cv);
+    bgv_ct_free(&cu);
+    poly_free(&du);
+    poly_free(&u);
+    bgv_key_free(&k);
+    bgv_free(&b);
+  }
+
   return 0;
 }
@@ -0,0 +1,80 @@
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <fhe.h>
+
+#include "ntt.h"
+#include "params.h"
+
+int main() {
+  ring_t r;
+  poly_t a, b;
+  const ntt_impl_t *ref = ntt_impl_isa(NTT_SCALAR);
+
+  ring_init(&r, LGD, LGQ, LGM);
+  poly_rand(&r, &a, UNIFORM);
+  poly_zero(&r, &b);
+
+  for (int isa = NTT_SCALAR; isa < NTT_ISA_COUNT; ++isa) {
+    const ntt_impl_t *impl = ntt_impl_isa(isa);
+    if (!impl)
+      continue;
+
+    for (size_t i = 0; i < r.n; ++i) {
+      size_t offset = i << r.lgd;
+      const uint_t *w = r.roots + offset, *wp = r.roots_shoup + offset;
+      const uint_t *iw = r.iroots + offset, *iwp = r.iroots_shoup + offset;
+      uint_t *x = a.b + offset, *y = b.b + offset;
+
+      memcpy(y, x, sizeof(uint_t) * r.d);
+      _ntt(ref, w, wp, x, r.d, r.m[i]);
+      _ntt_blocked(impl, w, wp, y, r.d, r.m[i]);
+      assert(!memcmp(x, y, sizeof(uint_t) * r.d));
+
+      _intt(ref, iw, iwp, x, r.d, r.m[i], r.dinv[i], r.dinv_shoup[i]);
+      _intt_blocked(impl, iw, iwp, y, r.d, r.m[i], r.dinv[i],
+                    r.dinv_shoup[i]);
+      assert(!memcmp(x, y, sizeof(uint_t) * r.d));
+
+      _ntt(impl, w, wp, y, r.d, r.m[i]);
+      _intt(impl, iw, iwp, y, r.d, r.m[i], r.dinv[i], r.dinv_shoup[i]);
+      assert(!memcmp(x, y, sizeof(uint_t) * r.d));
+    }
+  }
+
+  poly_free(&b);
+  poly_clone(&b, &a);
+  poly_ntt(&b);
+  poly_intt(&b);
+  assert(poly_cmp(&a, &b));
+
+  {
+    poly_t c, e;
+    poly_t *batch[] = {&a, &c, &e};
+
+    poly_clone(&c, &b);
+    poly_rand(&r, &e, UNIFORM);
+    poly_ntt(&b);
+    poly_ntt(&e);
+    poly_ntt_batch(batch, 3);
+    assert(a.is_ntt && c.is_ntt && e.is_ntt);
+    assert(poly_cmp(&a, &b));
+    assert(poly_cmp(&c, &b));
+
+    poly_intt_batch(batch, 2);
+    poly_intt(&b);
+    assert(!a.is_ntt && !c.is_ntt && e.is_ntt);
+    assert(poly_cmp(&a, &b));
+    assert(poly_cmp(&c, &b));
+
+    poly_free(&e);
+    poly_free(&c);
+  }
+
+  poly_free(&b);
+  poly_free(&a);
+  ring_free(&r);
+
+  return 0;
+}
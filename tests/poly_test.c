@@ -1,10 +1,12 @@
 #include <assert.h>
+#include <errno.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include <fhe.h>
 
 #include "params.h"
+#include "utils/number_theory.h"
 
 int main() {
   ring_t r;
@@ -49,6 +51,64 @@ int main() {
   memset(y, 0, sizeof y);
   assert(!memcmp(x, y, sizeof x));
 
+  poly_add(&ab, &b, &c);
+  poly_sub(&ac, &b, &c);
+  poly_mul(&bc, &b, &c);
+  for (size_t i = 0; i < r.d * r.n; ++i) {
+    assert(ab.b[i] == modadd(b.b[i], c.b[i], r.m[i >> r.lgd]));
+    assert(ac.b[i] == modsub(b.b[i], c.b[i], r.m[i >> r.lgd]));
+    assert(bc.b[i] == modmul(b.b[i], c.b[i], r.m[i >> r.lgd]));
+  }
+
+  poly_mul_add(&ab, &b, &c, &one);
+  poly_mul_sub(&ac, &b, &c, &one);
+  poly_free(&d);
+  poly_clone(&d, &one);
+  poly_fma(&d, &b, &c);
+  for (size_t i = 0; i < r.d * r.n; ++i) {
+    assert(ab.b[i] == modadd(bc.b[i], one.b[i], r.m[i >> r.lgd]));
+    assert(ac.b[i] == modsub(one.b[i], bc.b[i], r.m[i >> r.lgd]));
+    assert(d.b[i] == ab.b[i]);
+  }
+
+  {
+    const poly_t *u[] = {&b, &c, &one}, *v[] = {&c, &b, &one};
+    poly_dot(&ab, u, v, 3);
+    poly_mul(&ac, &b, &c);
+    poly_add(&ac, &ac, &ac);
+    poly_fma(&ac, &one, &one);
+    assert(poly_cmp(&ab, &ac));
+  }
+
+  {
+    poly_t x[2], y[2], z[3];
+    poly_clone(x, &b);
+    poly_clone(x + 1, &c);
+    poly_clone(y, &c);
+    poly_clone(y + 1, &one);
+    for (int i = 0; i < 3; ++i)
+      poly_zero(&r, z + i);
+    poly_tensor(z, x, y);
+    poly_mul(&ab, &b, &c);
+    assert(poly_cmp(z, &ab));
+    poly_mul(&ab, &c, &one);
+    assert(poly_cmp(z + 2, &ab));
+    poly_mul(&ab, &b, &one);
+    poly_fma(&ab, &c, &c);
+    assert(poly_cmp(z + 1, &ab));
+    for (int i = 0; i < 3; ++i)
+      poly_free(z + i);
+    for (int i = 0; i < 2; ++i) {
+      poly_free(x + i);
+      poly_free(y + i);
+    }
+  }
+
+  poly_cmul(&ab, &b, -3);
+  poly_cmul(&ac, &b, 3);
+  poly_neg(&ac);
+  assert(poly_cmp(&ab, &ac));
+
   poly_free(&a);
   poly_clone(&a, &b);
   poly_mul(&b, &b, &one);
@@ -59,6 +119,134 @@ int main() {
   poly_deserialize(&b, buff);
   assert(poly_cmp(&a, &b));
 
+  {
+    ring_pool_stats_t st;
+    ring_pool_stats(&r, &st);
+    assert(!st.hits && !st.misses && !st.cached);
+
+    assert(!ring_pool_init(&r, 2));
+    assert(ring_pool_init(&r, 2) == -EEXIST);
+    poly_free(&d);
+    poly_free(&bc);
+    poly_free(&ac);
+    ring_pool_stats(&r, &st);
+    assert(!st.hits && !st.misses && st.cached == 2);
+
+    poly_zero(&r, &d);
+    poly_clone(&bc, &b);
+    poly_rand(&r, &ac, UNIFORM);
+    ring_pool_stats(&r, &st);
+    assert(st.hits == 2 && st.misses == 1 && !st.cached);
+    assert(poly_cmp(&bc, &b));
+    for (size_t i = 0; i < r.d * r.n; ++i)
+      assert(!d.b[i]);
+  }
+
+  {
+    /* Automorphisms commute with the NTT and map x to x^g */
+    const size_t g = 5;
+    poly_copy(&d, &a);
+    poly_ntt(&d);
+    poly_automorph(&ac, &d, g);
+    poly_intt(&ac);
+    poly_automorph(&c, &a, g);
+    assert(poly_cmp(&c, &ac));
+
+    memset(x, 0, sizeof x);
+    x[r.d - 1] = 1;
+    poly_free(&bc);
+    poly_encode(&r, x, &bc);
+    poly_automorph(&ac, &bc, g);
+    poly_intt(&ac);
+    poly_decode(y, &ac, T);
+    /* x^(5 (d - 1)) = x^(4d) x^(d - 5) */
+    for (size_t i = 0; i < r.d; ++i)
+      assert(y[i] == (i == r.d - g));
+  }
+
+  {
+    /* Uniform residues span each limb, small samples agree across limbs */
+    size_t cnt[3] = {0};
+    uint_t hi = 0;
+
+    poly_free(&ac);
+    poly_rand(&r, &ac, UNIFORM);
+    for (size_t i = 0; i < r.d * r.n; ++i) {
+      assert(ac.b[i] < r.m[i >> r.lgd]);
+      hi |= ac.b[i] >> (LGM - 1);
+    }
+    assert(hi);
+    poly_free(&ac);
+
+    poly_rand(&r, &ac, TERNARY);
+    for (size_t j = 0; j < r.d; ++j) {
+      const uint_t v = ac.b[j], s = v == r.m[0] - 1 ? 2 : v;
+      assert(s < 3);
+      cnt[s]++;
+      for (size_t i = 1; i < r.n; ++i)
+        assert(ac.b[(i << r.lgd) + j] == (s == 2 ? r.m[i] - 1 : s));
+    }
+    for (size_t k = 0; k < 3; ++k)
+      assert(cnt[k] > r.d / 4 && cnt[k] < r.d / 2);
+  }
+
+  {
+    /* Generators replay their polynomials from the seed and nonce */
+    const unsigned char seed[POLY_SEED_BYTES] = {7};
+    poly_rng_t g, h;
+
+    poly_rng_init(&g, seed);
+    poly_rng_init(&h, seed);
+    for (DISTRIBUTION k = UNIFORM; k <= ERR_CDT; ++k) {
+      poly_free(&ac);
+      poly_free(&bc);
+      poly_rand_rng(&r, &ac, k, &g);
+      poly_rand_rng(&r, &bc, k, &h);
+      assert(poly_cmp(&ac, &bc));
+      for (size_t i = 0; i < r.d * r.n; ++i)
+        assert(ac.b[i] < r.m[i >> r.lgd]);
+    }
+    assert(g.nonce == 4);
+
+    h.nonce = 1;
+    poly_free(&bc);
+    poly_rand_rng(&r, &bc, TERNARY, &h);
+    poly_free(&ac);
+    poly_rand_rng(&r, &ac, TERNARY, &g);
+    assert(!poly_cmp(&ac, &bc));
+    g.nonce = 1;
+    poly_free(&ac);
+    poly_rand_rng(&r, &ac, TERNARY, &g);
+    assert(poly_cmp(&ac, &bc));
+  }
+
+  {
+    /* Fast decoding agrees with the multiprecision reference */
+    const uint_t ts[] = {T, 2, (1ULL << 61) - 1};
+    poly_t lo = a;
+
+    for (size_t k = 0; k < 3; ++k) {
+      poly_decode(x, &a, ts[k]);
+      poly_decode_mp(y, &a, ts[k]);
+      assert(!memcmp(x, y, sizeof x));
+    }
+
+    /* Below the top level, only the first limbs are reconstructed */
+    lo.n = r.n / 2;
+    poly_decode(x, &lo, T);
+    poly_decode_mp(y, &lo, T);
+    assert(!memcmp(x, y, sizeof x));
+
+    /* Small signed coefficients, lifted from mod t */
+    for (size_t i = 0; i < r.d; ++i)
+      y[i] = (T - 1 - i * 7919 % 64) % T;
+    poly_free(&bc);
+    poly_encode_mod(&r, y, T, &bc);
+    poly_intt(&bc);
+    poly_decode(x, &bc, T);
+    assert(!memcmp(x, y, sizeof x));
+  }
+
   free(buff);
   poly_free(&b);
   poly_free(&a);
@@ -71,5 +259,12 @@ int main() {
   poly_free(&one);
   ring_free(&r);
 
+  {
+    /* Residues are limited to 60 bits even when asserts are compiled out */
+    int err = ring_init_congruent(&r, LGD, LGQ, 61, T);
+    assert(err == -EINVAL);
+    (void)err;
+  }
+
   return 0;
 }
@@ -0,0 +1,73 @@
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "rand/random.h"
+#include "rand/sample.h"
+
+/* RFC 8439, section 2.3.2 */
+static const uint8_t block[64] = {
+    0x10, 0xf1, 0xe7, 0xe4, 0xd1, 0x3b, 0x59, 0x15, 0x50, 0x0f, 0xdd,
+    0x1f, 0xa3, 0x20, 0x71, 0xc4, 0xc7, 0xd1, 0xf4, 0xc7, 0x33, 0xc0,
+    0x68, 0x03, 0x04, 0x22, 0xaa, 0x9a, 0xc3, 0xd4, 0x6c, 0x4e, 0xd2,
+    0x82, 0x64, 0x46, 0x07, 0x9f, 0xaa, 0x09, 0x14, 0xc2, 0xd7, 0x05,
+    0xd9, 0x8b, 0x02, 0xa2, 0xb5, 0x12, 0x9c, 0xd1, 0xde, 0x16, 0x4e,
+    0xb9, 0xcb, 0xd0, 0x83, 0xe8, 0xa2, 0x50, 0x3c, 0x4e};
+
+int main() {
+  static uint8_t x[CHACHA20_BLOCKBYTES * 20], y[CHACHA20_BLOCKBYTES * 20];
+  static uint64_t u[1000];
+  static int64_t e[1 << 16];
+  static uint64_t v[100], w[100];
+  uint8_t key[CHACHA20_KEYBYTES];
+  uint32_t s[16], t[16];
+  size_t bits = 0;
+  double var = 0;
+
+  for (int i = 0; i < CHACHA20_KEYBYTES; ++i)
+    key[i] = i;
+  chacha_init(s, key);
+  s[12] = 1;
+  s[13] = 0x09000000;
+  s[14] = 0x4a000000;
+  chacha_keystream_bytes(s, x, sizeof block);
+  assert(!memcmp(x, block, sizeof block));
+
+  /* Multi-block keystream matches the scalar one, across a counter carry */
+  for (size_t n = 1; n <= 20; ++n) {
+    chacha_init(s, key);
+    s[12] = 0xfffffffc;
+    memcpy(t, s, sizeof s);
+    chacha_keystream_bytes(s, x, n * CHACHA20_BLOCKBYTES);
+    chacha_blocks(t, y, n);
+    assert(!memcmp(x, y, n * CHACHA20_BLOCKBYTES));
+    assert(!memcmp(s, t, sizeof s));
+  }
+
+  /* Any range of a keyed stream is read without the words before it */
+  rng_stream_u64(key, 3, 5, (1ULL << 35) - 20, v, 100);
+  for (size_t pos = 0; pos < 100; pos += 13) {
+    const size_t n = pos + 30 < 100 ? 30 : 100 - pos;
+    rng_stream_u64(key, 3, 5, (1ULL << 35) - 20 + pos, w, n);
+    assert(!memcmp(v + pos, w, n * sizeof(uint64_t)));
+  }
+
+  /* Bulk draws go straight to the buffer and look balanced */
+  rng_fill_u64(u, 1000);
+  rng_fill_u64(u + 997, 3);
+  for (size_t i = 0; i < 1000; ++i)
+    bits += __builtin_popcountll(u[i]);
+  assert(bits > 31000 && bits < 33000);
+
+  /* Table samples are bounded and have the variance of sample_err */
+  sample_cdt_n(e, 1 << 16);
+  for (size_t i = 0; i < (1 << 16); ++i) {
+    assert(e[i] >= -CDT_LEN && e[i] <= CDT_LEN);
+    var += (double)(e[i] * e[i]);
+  }
+  var /= 1 << 16;
+  assert(fabs(var - SIGMA * SIGMA) < 0.5);
+
+  return 0;
+}
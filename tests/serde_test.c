@@ -1,4 +1,6 @@
 #include <assert.h>
+#include <errno.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -29,31 +31,196 @@ int main() {
   }
 
   {
-    buf = malloc((2 * b.r.d * b.r.n * 8) + 4);
+    bgv_ct_t w;
+    int err;
+
     bgv_encrypt(&b, &u, &k.pub, &x);
+    bgv_ct_modswitch(&b, &u);
+    buf = malloc(bgv_ct_size(&u));
 
     bgv_ct_serialize(buf, &u);
-    bgv_ct_deserialize(&b.r, &v, buf);
+    err = bgv_ct_deserialize(&b.r, &v, buf);
+    assert(!err);
+    err = bgv_ct_deserialize_seeded(&b.r, &w, buf);
+    assert(err == -EINVAL);
 
     assert(u.n == v.n);
+    assert(bgv_ct_level(&v) == b.r.n - 2);
     for (size_t i = 0; i < u.n; ++i)
       assert(poly_cmp(u.c + i, v.c + i));
 
     free(buf);
+    (void)err;
+  }
+
+  {
+    /* Deserialized ciphertexts are in NTT form and can switch levels */
+    static uint_t want[D], got[D];
+    bgv_ct_t w;
+    poly_t m;
+    int err;
+
+    for (size_t j = 0; j < b.r.d; ++j)
+      want[j] = (j * 31 + 5) % T;
+    poly_encode(&b.r, want, &m);
+    bgv_encrypt(&b, &w, &k.pub, &m);
+    buf = malloc(bgv_ct_size(&w));
+    bgv_ct_serialize(buf, &w);
+    bgv_ct_free(&w);
+
+    err = bgv_ct_deserialize(&b.r, &w, buf);
+    assert(!err);
+    bgv_ct_modswitch(&b, &w);
+    poly_free(&m);
+    bgv_decrypt(&m, &w, &k.s);
+    poly_decode(got, &m, T);
+    assert(!memcmp(got, want, sizeof got));
+    bgv_ct_free(&w);
+
+    /* Corrupt headers are refused rather than clamped */
+    buf[4] = 0;
+    assert(bgv_ct_deserialize(&b.r, &w, buf) == -EINVAL);
+    buf[4] = b.r.n + 1;
+    assert(bgv_ct_deserialize(&b.r, &w, buf) == -EINVAL);
+    buf[4] = b.r.n;
+    buf[0] = 4;
+    assert(bgv_ct_deserialize(&b.r, &w, buf) == -EINVAL);
+    buf[0] = 1;
+    assert(bgv_ct_deserialize(&b.r, &w, buf) == -EINVAL);
+
+    free(buf);
+    poly_free(&m);
+    (void)err;
+  }
+
+  {
+    /* Seeded secret key encryptions store c0 and the seed of c1 */
+    static uint_t want[D], got[D];
+    unsigned char seed[POLY_SEED_BYTES];
+    bgv_ct_t w, z;
+    poly_t m;
+    int err;
+
+    for (size_t j = 0; j < b.r.d; ++j)
+      want[j] = (j * 7919) % T;
+    poly_encode(&b.r, want, &m);
+    bgv_encrypt_sym(&b, &w, &k.s, &m, seed);
+    assert(bgv_ct_seeded_size(&w) < bgv_ct_size(&w) / 2 + 64);
+    buf = malloc(bgv_ct_seeded_size(&w));
+
+    err = bgv_ct_serialize_seeded(buf, &w, seed);
+    assert(!err);
+    err = bgv_ct_deserialize(&b.r, &z, buf);
+    assert(err == -EINVAL);
+    err = bgv_ct_deserialize_seeded(&b.r, &z, buf);
+    assert(!err);
+    assert(w.n == z.n);
+    for (size_t i = 0; i < w.n; ++i)
+      assert(poly_cmp(w.c + i, z.c + i));
+
+    poly_free(&m);
+    bgv_decrypt(&m, &z, &k.s);
+    poly_decode(got, &m, T);
+    assert(!memcmp(got, want, sizeof got));
+
+    bgv_ct_modswitch(&b, &z);
+    assert(bgv_ct_serialize_seeded(buf, &z, seed) == -EINVAL);
+
+    /* The seed only expands to c1 at the top level */
+    err = bgv_ct_serialize_seeded(buf, &w, seed);
+    assert(!err);
+    buf[4]--;
+    bgv_ct_free(&z);
+    err = bgv_ct_deserialize_seeded(&b.r, &z, buf);
+    assert(err == -EINVAL);
+
+    /* Nor once an operation has rewritten c1 */
+    bgv_ct_mul_scalar(&w, &w, 3);
+    assert(bgv_ct_serialize_seeded(buf, &w, seed) == -EINVAL);
+
+    free(buf);
+    bgv_ct_free(&w);
+    poly_free(&m);
+    (void)err;
   }
 
   {
-    buf = malloc(5 * b.r.d * b.r.n * 8);
+    /* The uniform key components are stored as seeds. The default key has
+     * one digit per limb, 2 + n polys against 3 + 2n with every a_j. */
+    const size_t len = (b.r.d * b.r.n) << 3;
+    int err;
+
+    assert(k.eval.dnum == b.r.n);
+    assert(bgv_key_size(&k) == len * (2 + b.r.n) + 4 + 2 * POLY_SEED_BYTES);
+    assert(bgv_key_size(&k) < len * (3 + 2 * b.r.n) / 2 + len);
+    buf = malloc(bgv_key_size(&k));
     bgv_key_serialize(buf, &k);
-    bgv_key_deserialize(&b.r, &l, buf);
+    err = bgv_key_deserialize(&b.r, &l, buf);
+    assert(!err);
+    assert(bgv_key_cmp(&k, &l));
 
-    assert(poly_cmp(&k.s, &l.s));
-    assert(poly_cmp(&k.pub.a, &l.pub.a));
-    assert(poly_cmp(&k.pub.b, &l.pub.b));
-    assert(poly_cmp(&k.eval.a, &l.eval.a));
-    assert(poly_cmp(&k.eval.b, &l.eval.b));
+    /* A single differing key switching term makes the keys differ */
+    l.eval.k[l.eval.dnum - 1].b.b[0] ^= 1;
+    assert(!bgv_key_cmp(&k, &l));
 
     free(buf);
+    (void)len;
+    (void)err;
+  }
+
+  {
+    /* Saved rings map back with the same tables and work as built */
+    const char *path = "serde_test.ring";
+    static uint_t want[1 << LGD], got[1 << LGD];
+    bgv_key_t kc;
+    bgv_ct_t uc;
+    poly_t xc, yc;
+    bgv_t c;
+    FILE *f;
+    int err;
+
+    err = ring_save(&b.r, path);
+    assert(!err);
+    err = bgv_init_file(&c, path, 3, BGV_DNUM);
+    assert(err == -EINVAL);
+    err = bgv_init_file(&c, path, T, BGV_DNUM);
+    assert(!err);
+    assert(c.r.map && c.r.n == b.r.n && c.r.d == b.r.d);
+    assert(!mpz_cmp(c.r.M, b.r.M) && !mpz_cmp(c.r.M_half, b.r.M_half));
+    assert(!mpz_cmp(c.r.ms[1], b.r.ms[1]));
+    assert(!memcmp(c.r.m, b.r.m, sizeof(uint_t) * b.r.n));
+    assert(!memcmp(c.r.invms, b.r.invms, sizeof(uint_t) * b.r.n));
+    assert(!memcmp(c.r.barrett, b.r.barrett, sizeof(uint_t) * b.r.n));
+    assert(!memcmp(c.r.roots_shoup, b.r.roots_shoup,
+                   sizeof(uint_t) * (b.r.n << b.r.lgd)));
+    assert(!memcmp(c.r.iroots, b.r.iroots,
+                   sizeof(uint_t) * (b.r.n << b.r.lgd)));
+
+    bgv_keygen(&c, &kc);
+    for (size_t j = 0; j < c.r.d; ++j)
+      want[j] = (j * 7) % T;
+    poly_encode(&c.r, want, &xc);
+    bgv_encrypt(&c, &uc, &kc.pub, &xc);
+    bgv_decrypt(&yc, &uc, &kc.s);
+    poly_decode(got, &yc, T);
+    assert(!memcmp(got, want, sizeof got));
+    bgv_ct_free(&uc);
+    poly_free(&xc);
+    poly_free(&yc);
+    bgv_key_free(&kc);
+    bgv_free(&c);
+
+    /* Any corrupted word is caught by the checksum */
+    f = fopen(path, "r+b");
+    fseek(f, 64 + 8 * 1000, SEEK_SET);
+    fputc(0x55, f);
+    fclose(f);
+    err = ring_load(&c.r, path);
+    assert(err == -EINVAL);
+    remove(path);
+    err = ring_load(&c.r, path);
+    assert(err == -ENOENT);
+    (void)err;
   }
 
   bgv_ct_free(&v);